@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    AnalyserFifo.h
+
+    Wait-free queue of mono samples from the audio thread to the analyser.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    The audio thread push()es each block, mixed down to mono, and the
+    analyser thread pull()s whatever has arrived. The storage is allocated
+    once in the constructor, so neither side ever allocates, locks or waits.
+
+    If the analyser falls behind, push() drops the samples that don't fit
+    rather than overwriting ones the reader may be looking at.
+
+    Only one thread may push and one thread may pull at any time.
+*/
+class AnalyserFifo
+{
+public:
+    explicit AnalyserFifo(int capacity)
+        : fifo(capacity), samples((size_t) capacity)
+    {
+    }
+
+    /** Producer: mixes numChannels channels down and queues as much as fits. */
+    void push(const float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if (numChannels <= 0)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        const auto gain = 1.0f / (float) numChannels;
+        mixInto(samples.data() + start1, channels, numChannels, 0, size1, gain);
+        mixInto(samples.data() + start2, channels, numChannels, size1, size2, gain);
+
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    /** Consumer: copies up to maxSamples queued samples and returns how many. */
+    int pull(float* destination, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+        juce::FloatVectorOperations::copy(destination, samples.data() + start1, size1);
+        juce::FloatVectorOperations::copy(destination + size1, samples.data() + start2, size2);
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    /** Consumer: throws away everything that's queued. */
+    void discard() noexcept { fifo.finishedRead(fifo.getNumReady()); }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    static void mixInto(float* destination, const float* const* channels, int numChannels,
+                        int offset, int numSamples, float gain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + offset, gain, numSamples);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, channels[channel] + offset, gain, numSamples);
+    }
+
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalyserFifo)
+};
@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    BandGraph.cpp
+
+  ==============================================================================
+*/
+
+#include "BandGraph.h"
+
+namespace
+{
+    // Owners are numbered per stage of each slot: the low cut, the bands in
+    // order, then the high cut.
+    constexpr int lowCutSlot = 0, highCutSlot = maxGraphBands + 1;
+
+    std::uint16_t getOwner(int slot, int stage) noexcept
+    {
+        return (std::uint16_t) (slot * maxButterworthStages + stage);
+    }
+
+    void addSection(BandGraphCoefficients& result, const BiquadCoefficients& section, std::uint16_t owner) noexcept
+    {
+        const auto i = (size_t) result.numSections++;
+
+        result.b0[i] = section.b0;
+        result.b1[i] = section.b1;
+        result.b2[i] = section.b2;
+        result.a1[i] = section.a1;
+        result.a2[i] = section.a2;
+        result.owners[i] = owner;
+    }
+
+    void addCut(BandGraphCoefficients& result, int slot, float frequency, int numStages, double sampleRate, bool isHighpass) noexcept
+    {
+        std::array<BiquadCoefficients, maxButterworthStages> stages;
+        numStages = juce::jlimit(1, maxButterworthStages, numStages);
+        designButterworthSections(stages.data(), numStages, frequency, sampleRate, isHighpass);
+
+        for (int i = 0; i < numStages; ++i)
+            addSection(result, stages[(size_t) i], getOwner(slot, i));
+    }
+}
+
+void applyChainSettings(BandGraphSettings& graph, const ChainSettings& chain) noexcept
+{
+    graph.lowCutFreq = chain.lowCutFreq;
+    graph.highCutFreq = chain.highCutFreq;
+    graph.lowCutStages = (int) chain.lowCutSlope + 1;
+    graph.highCutStages = (int) chain.highCutSlope + 1;
+    graph.bands[0] = { BandType::peak, chain.peakFreq, chain.peakGaininDecibels, chain.peakQuality };
+}
+
+bool isBandActive(const BandSettings& band) noexcept
+{
+    return band.type != BandType::off && std::abs(band.gainInDecibels) > neutralDecibels;
+}
+
+BandGraphCoefficients makeBandGraphCoefficients(const BandGraphSettings& settings, double sampleRate) noexcept
+{
+    jassert(sampleRate > 0);
+
+    BandGraphCoefficients result;
+    result.sampleRate = sampleRate;
+
+    // The cuts are bypassed when they're inaudible, as in the chain.
+    const auto nyquist = (float) (sampleRate * 0.5);
+
+    if (isCutAudible(settings.lowCutFreq, 2 * settings.lowCutStages, true))
+        addCut(result, lowCutSlot, juce::jmin(settings.lowCutFreq, nyquist), settings.lowCutStages, sampleRate, true);
+
+    for (int i = 0; i < maxGraphBands; ++i)
+    {
+        const auto& band = settings.bands[(size_t) i];
+
+        if (! isBandActive(band))
+            continue;
+
+        // Above Nyquist the designs aren't stable, which low host rates can reach.
+        const auto frequency = juce::jmin((double) band.frequency, sampleRate * 0.49);
+        const auto gain = (double) juce::Decibels::decibelsToGain(band.gainInDecibels);
+        const auto quality = (double) juce::jmax(0.01f, band.quality);
+        BiquadCoefficients section;
+
+        switch (band.type)
+        {
+        case BandType::lowShelf:  section = makeLowShelfCoefficients(sampleRate, frequency, quality, gain); break;
+        case BandType::highShelf: section = makeHighShelfCoefficients(sampleRate, frequency, quality, gain); break;
+        case BandType::peak:
+        case BandType::off:
+        default:                  section = makePeakCoefficients(sampleRate, frequency, quality, gain); break;
+        }
+
+        addSection(result, section, getOwner(i + 1, 0));
+    }
+
+    if (isCutAudible(settings.highCutFreq, 2 * settings.highCutStages, false))
+        addCut(result, highCutSlot, juce::jmin(settings.highCutFreq, nyquist), settings.highCutStages, sampleRate, false);
+
+    return result;
+}
+
+int getDecayLengthInSamples(const BandGraphCoefficients& coefficients, double decibels)
+{
+    std::array<BiquadCoefficients, BandGraphCoefficients::maxSections> sections;
+
+    for (int i = 0; i < coefficients.numSections; ++i)
+        sections[(size_t) i] = coefficients.getSection(i);
+
+    return getDecayLengthInSamples(sections.data(), coefficients.numSections, coefficients.sampleRate, decibels);
+}
+
+//==============================================================================
+void BandGraph::reset() noexcept
+{
+    std::fill(getRow(s1Row), getRow(numRows), 0.0f);
+}
+
+bool BandGraph::hasSameSections(const BandGraphCoefficients& other) const noexcept
+{
+    return other.numSections == target.numSections
+        && std::equal(other.owners.begin(), other.owners.begin() + other.numSections, target.owners.begin());
+}
+
+void BandGraph::setCoefficients(const BandGraphCoefficients& newCoefficients) noexcept
+{
+    if (! hasSameSections(newCoefficients))
+    {
+        // Find where each surviving section's state was, before it moves.
+        std::array<std::int8_t, BandGraphCoefficients::numOwners> oldIndex;
+        oldIndex.fill(-1);
+
+        for (int i = 0; i < target.numSections; ++i)
+            oldIndex[target.owners[(size_t) i]] = (std::int8_t) i;
+
+        std::array<float, maxSections> s1{}, s2{};
+        const auto* oldS1 = getRow(s1Row);
+        const auto* oldS2 = getRow(s2Row);
+
+        for (int i = 0; i < newCoefficients.numSections; ++i)
+        {
+            const auto from = oldIndex[newCoefficients.owners[(size_t) i]];
+
+            if (from >= 0)
+            {
+                s1[(size_t) i] = oldS1[from];
+                s2[(size_t) i] = oldS2[from];
+            }
+        }
+
+        std::copy(s1.begin(), s1.end(), getRow(s1Row));
+        std::copy(s2.begin(), s2.end(), getRow(s2Row));
+    }
+
+    target = newCoefficients;
+    rampRemaining = 0;
+
+    std::copy(target.b0.begin(), target.b0.end(), getRow(b0Row));
+    std::copy(target.b1.begin(), target.b1.end(), getRow(b1Row));
+    std::copy(target.b2.begin(), target.b2.end(), getRow(b2Row));
+    std::copy(target.a1.begin(), target.a1.end(), getRow(a1Row));
+    std::copy(target.a2.begin(), target.a2.end(), getRow(a2Row));
+}
+
+void BandGraph::rampTo(const BandGraphCoefficients& newCoefficients, int numSamples) noexcept
+{
+    if (numSamples <= 0 || ! hasSameSections(newCoefficients))
+    {
+        setCoefficients(newCoefficients);
+        return;
+    }
+
+    target = newCoefficients;
+    rampRemaining = numSamples;
+
+    const auto scale = 1.0f / (float) numSamples;
+    const auto numSections = target.numSections;
+    const std::array<const float*, numCoefficientRows> targetRows{ target.b0.data(), target.b1.data(), target.b2.data(),
+                                                                   target.a1.data(), target.a2.data() };
+
+    for (int row = 0; row < numCoefficientRows; ++row)
+    {
+        const auto* current = getRow(row);
+        const auto* to = targetRows[(size_t) row];
+        auto* increment = getRow(numCoefficientRows + row);
+
+        for (int i = 0; i < numSections; ++i)
+            increment[i] = (to[i] - current[i]) * scale;
+    }
+}
+
+void BandGraph::process(float* samples, int numSamples) noexcept
+{
+    if (rampRemaining > 0)
+    {
+        const auto numInRamp = juce::jmin(rampRemaining, numSamples);
+        processRamp(samples, numInRamp);
+
+        samples += numInRamp;
+        numSamples -= numInRamp;
+    }
+
+    processSections(samples, numSamples);
+
+    // Once per block, after the ramp as well, rather than on every sample.
+    auto* s1 = getRow(s1Row);
+    auto* s2 = getRow(s2Row);
+
+    for (int k = 0; k < target.numSections; ++k)
+    {
+        juce::dsp::util::snapToZero(s1[k]);
+        juce::dsp::util::snapToZero(s2[k]);
+    }
+}
+
+void BandGraph::processSections(float* samples, int numSamples) noexcept
+{
+    const auto numSections = target.numSections;
+    const auto* b0 = getRow(b0Row);
+    const auto* b1 = getRow(b1Row);
+    const auto* b2 = getRow(b2Row);
+    const auto* a1 = getRow(a1Row);
+    const auto* a2 = getRow(a2Row);
+    auto* s1 = getRow(s1Row);
+    auto* s2 = getRow(s2Row);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = samples[i];
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            const auto y = b0[k] * x + s1[k];
+            s1[k] = b1[k] * x - a1[k] * y + s2[k];
+            s2[k] = b2[k] * x - a2[k] * y;
+            x = y;
+        }
+
+        samples[i] = x;
+    }
+}
+
+void BandGraph::processRamp(float* samples, int numSamples) noexcept
+{
+    const auto numSections = target.numSections;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int row = 0; row < numCoefficientRows; ++row)
+        {
+            auto* coefficients = getRow(row);
+            const auto* increments = getRow(numCoefficientRows + row);
+
+            for (int k = 0; k < numSections; ++k)
+                coefficients[k] += increments[k];
+        }
+
+        processSections(samples + i, 1);
+    }
+
+    rampRemaining -= numSamples;
+
+    // Land exactly on the target rather than wherever rounding has got to.
+    if (rampRemaining <= 0)
+        setCoefficients(target);
+}
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    BandGraph.h
+
+    A runtime-sized filter engine: up to maxGraphBands peak and shelf bands
+    between two Butterworth cuts of up to 96 dB/oct, where MonoChain is fixed
+    at one peak and 48 dB/oct.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+enum class BandType
+{
+    off,
+    peak,
+    lowShelf,
+    highShelf
+};
+
+struct BandSettings
+{
+    BandType type{ BandType::off };
+    float frequency{ 1000.f }, gainInDecibels{ 0 }, quality{ 1.f };
+};
+
+constexpr int maxGraphBands = 24;
+
+struct BandGraphSettings
+{
+    float lowCutFreq{ minCutFrequency }, highCutFreq{ maxCutFrequency };
+    int lowCutStages{ 1 }, highCutStages{ 1 };     // 12 dB/oct each, up to maxButterworthStages
+    std::array<BandSettings, maxGraphBands> bands;
+};
+
+/** Takes the cuts from a ChainSettings, and its peak as the first band.
+    The other bands are left as they are.
+*/
+void applyChainSettings(BandGraphSettings& graph, const ChainSettings& chain) noexcept;
+
+/** False for a band that's switched off or has no gain, like isBandActive()
+    for the chain's peak.
+*/
+bool isBandActive(const BandSettings& band) noexcept;
+
+/**
+    The sections of a graph in processing order: the low cut stages, the
+    active bands, then the high cut stages. Bands that aren't active take no
+    sections at all, so the cost grows with what's in use rather than with
+    maxGraphBands.
+
+    The coefficients are stored as a structure of arrays and the first
+    numSections entries of each are in use. owners says which band and stage
+    each section came from, so a section's state can follow it when others
+    come and go.
+*/
+struct BandGraphCoefficients
+{
+    static constexpr int maxSections = maxGraphBands + 2 * maxButterworthStages;
+    static constexpr int numOwners = (maxGraphBands + 2) * maxButterworthStages;
+
+    double sampleRate{ 0 };
+    int numSections{ 0 };
+    std::array<float, maxSections> b0{}, b1{}, b2{}, a1{}, a2{};
+    std::array<std::uint16_t, maxSections> owners{};
+
+    BiquadCoefficients getSection(int index) const noexcept
+    {
+        const auto i = (size_t) index;
+        return { b0[i], b1[i], b2[i], a1[i], a2[i] };
+    }
+};
+
+static_assert(std::is_trivially_copyable<BandGraphCoefficients>::value, "");
+
+BandGraphCoefficients makeBandGraphCoefficients(const BandGraphSettings& settings, double sampleRate) noexcept;
+
+/** As getDecayLengthInSamples() for a ChainCoefficients. */
+int getDecayLengthInSamples(const BandGraphCoefficients& coefficients, double decibels);
+
+//==============================================================================
+/**
+    Runs one channel through a BandGraphCoefficients cascade.
+
+    The coefficients, their ramp increments and the section state all live in
+    one contiguous block of rows, one float per section in each, so a whole
+    graph stays cache resident and the per-sample ramp is a handful of
+    straight vector adds.
+*/
+class BandGraph
+{
+public:
+    BandGraph() = default;
+
+    void reset() noexcept;
+
+    /** Switches to new coefficients straight away. Sections that carry on
+        from the old set keep their state; new ones start from a clear state.
+    */
+    void setCoefficients(const BandGraphCoefficients& newCoefficients) noexcept;
+
+    /** Moves the coefficients linearly to the new ones over the next
+        numSamples samples. If the sections differ it jumps instead.
+    */
+    void rampTo(const BandGraphCoefficients& newCoefficients, int numSamples) noexcept;
+
+    void process(float* samples, int numSamples) noexcept;
+
+    /** True if the new coefficients use the same sections as these, so they
+        can be ramped to.
+    */
+    bool hasSameSections(const BandGraphCoefficients& other) const noexcept;
+
+    int getNumSections() const noexcept { return target.numSections; }
+    bool isRamping() const noexcept { return rampRemaining > 0; }
+
+private:
+    static constexpr int maxSections = BandGraphCoefficients::maxSections;
+
+    enum Row
+    {
+        b0Row, b1Row, b2Row, a1Row, a2Row,
+        numCoefficientRows,
+        s1Row = 2 * numCoefficientRows, s2Row,
+        numRows
+    };
+
+    float* getRow(int row) noexcept { return block.data() + row * maxSections; }
+
+    void processSections(float* samples, int numSamples) noexcept;
+    void processRamp(float* samples, int numSamples) noexcept;
+
+    // The coefficient rows, then an increment for each of them, then the state.
+    alignas(64) std::array<float, numRows * maxSections> block{};
+    BandGraphCoefficients target;
+    int rampRemaining{ 0 };
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Console entry point for rendering audio files through the EQ.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: BatchRenderer --out=<folder> [options] <files or folders...>\n"
+                     "\n"
+                     "  --preset=<file>         state saved by the plugin (binary or XML)\n"
+                     "  --lowcut=<Hz>           --lowcut-slope=<12|24|36|48>\n"
+                     "  --highcut=<Hz>          --highcut-slope=<12|24|36|48>\n"
+                     "  --peak-freq=<Hz>        --peak-gain=<dB>    --peak-q=<Q>\n"
+                     "  --threads=<n>           worker threads (default: one per core)\n"
+                     "\n"
+                     "  --split                 render a single file in parallel segments\n"
+                     "  --overlap=<s>           pre-roll per segment (default: from the filter decay)\n"
+                     "  --tolerance=<dB>        decay level the default overlap is sized for (-120)\n"
+                     "  --verify                compare the segmented render with a serial one\n"
+                     "\n"
+                     "Options given on the command line override the preset.\n";
+    }
+
+    Slope slopeFromDecibels(const juce::String& text)
+    {
+        return static_cast<Slope>(juce::jlimit((int) Slope_12, (int) Slope_48, text.getIntValue() / 12 - 1));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h") || ! args.containsOption("--out"))
+    {
+        printUsage();
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    auto settings = getDefaultChainSettings();
+
+    if (args.containsOption("--preset"))
+    {
+        const juce::File preset(args.getValueForOption("--preset"));
+
+        if (! loadChainSettings(preset, settings))
+        {
+            std::cerr << "Couldn't read preset " << preset.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    auto readFloat = [&args](const char* option, float& value)
+    {
+        if (args.containsOption(option))
+            value = args.getValueForOption(option).getFloatValue();
+    };
+
+    readFloat("--lowcut", settings.lowCutFreq);
+    readFloat("--highcut", settings.highCutFreq);
+    readFloat("--peak-freq", settings.peakFreq);
+    readFloat("--peak-gain", settings.peakGaininDecibels);
+    readFloat("--peak-q", settings.peakQuality);
+
+    if (args.containsOption("--lowcut-slope"))
+        settings.lowCutSlope = slopeFromDecibels(args.getValueForOption("--lowcut-slope"));
+
+    if (args.containsOption("--highcut-slope"))
+        settings.highCutSlope = slopeFromDecibels(args.getValueForOption("--highcut-slope"));
+
+    const juce::File outputFolder(args.getValueForOption("--out"));
+
+    if (! outputFolder.createDirectory())
+    {
+        std::cerr << "Couldn't create " << outputFolder.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    juce::Array<juce::File> inputs;
+
+    for (auto& arg : args.arguments)
+    {
+        if (arg.isOption())
+            continue;
+
+        auto file = arg.resolveAsFile();
+
+        if (file.isDirectory())
+            inputs.addArray(file.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff"));
+        else
+            inputs.add(file);
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0;
+    OfflineRenderer renderer(settings, numThreads);
+
+    if (args.containsOption("--split"))
+    {
+        if (inputs.size() != 1)
+        {
+            std::cerr << "--split renders exactly one file" << std::endl;
+            return 1;
+        }
+
+        SegmentOptions options;
+        options.verify = args.containsOption("--verify");
+
+        if (args.containsOption("--overlap"))
+            options.overlapSeconds = args.getValueForOption("--overlap").getDoubleValue();
+
+        if (args.containsOption("--tolerance"))
+            options.toleranceDecibels = args.getValueForOption("--tolerance").getDoubleValue();
+
+        juce::String error;
+        const auto& input = inputs.getReference(0);
+        const auto stats = renderer.renderSegmented(input, outputFolder.getChildFile(input.getFileName()), options, error);
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << input.getFullPathName() << ": " << error << std::endl;
+            return 1;
+        }
+
+        std::cout << "Rendered " << stats.numSegments << " segments with " << stats.overlapSamples << " samples of overlap ("
+                  << juce::String(stats.audioSeconds, 1) << " s of audio) in " << juce::String(stats.wallSeconds, 2) << " s, "
+                  << juce::String(stats.getRealtimeFactor(), 1) << "x realtime" << std::endl;
+
+        if (options.verify)
+            std::cout << "Largest difference from a serial render: " << juce::String(stats.maxErrorDecibels, 1) << " dBFS" << std::endl;
+
+        return 0;
+    }
+    const auto stats = renderer.renderFiles(inputs, outputFolder);
+
+    std::cout << "Rendered " << (stats.numFiles - stats.numFailed) << " of " << stats.numFiles << " files ("
+              << juce::String(stats.audioSeconds, 1) << " s of audio) in " << juce::String(stats.wallSeconds, 2) << " s\n"
+              << juce::String(stats.getFilesPerSecond(), 2) << " files/s, "
+              << juce::String(stats.getRealtimeFactor(), 1) << "x realtime" << std::endl;
+
+    return stats.numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,432 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "../CascadeKernel.h"
+#include "../PluginState.h"
+#include "../ParameterTable.h"
+
+ChainSettings getDefaultChainSettings()
+{
+    return ParameterSnapshot::getDefaults().getChainSettings();
+}
+
+bool loadChainSettings(const juce::File& presetFile, ChainSettings& settings)
+{
+    juce::MemoryBlock data;
+
+    if (! presetFile.loadFileAsData(data))
+        return false;
+
+    std::map<juce::uint32, float> values;
+
+    // A compact state has the values keyed by the hash of the parameter id.
+    // AudioProcessorValueTreeState keeps each one in a PARAM child holding
+    // its id and unnormalised value.
+    if (! readCompactState(data.getData(), data.getSize(), [&values](juce::uint32 idHash, float value) { values[idHash] = value; }))
+    {
+        auto state = juce::ValueTree::readFromData(data.getData(), data.getSize());
+
+        if (! state.isValid())
+            if (auto xml = juce::parseXML(presetFile))
+                state = juce::ValueTree::fromXml(*xml);
+
+        if (! state.isValid())
+            return false;
+
+        for (const auto& param : state)
+            if (param.hasProperty("id") && param.hasProperty("value"))
+                values[hashParameterID(param.getProperty("id").toString())] = (float) param.getProperty("value");
+    }
+
+    auto read = [&values](ParameterIndex index, float& value)
+    {
+        auto found = values.find(hashParameterID(getParameterID(index)));
+
+        if (found != values.end())
+            value = found->second;
+    };
+
+    auto readSlope = [&read](ParameterIndex index, Slope& slope)
+    {
+        auto value = (float) slope;
+        read(index, value);
+        slope = static_cast<Slope>(juce::jlimit((int) Slope_12, (int) Slope_48, juce::roundToInt(value)));
+    };
+
+    read(lowCutFreqParameter, settings.lowCutFreq);
+    read(highCutFreqParameter, settings.highCutFreq);
+    read(peakFreqParameter, settings.peakFreq);
+    read(peakGainParameter, settings.peakGaininDecibels);
+    read(peakQualityParameter, settings.peakQuality);
+    readSlope(lowCutSlopeParameter, settings.lowCutSlope);
+    readSlope(highCutSlopeParameter, settings.highCutSlope);
+
+    return true;
+}
+
+//==============================================================================
+void RenderChains::prepare(int numChannels, int blockSize, const ChainCoefficients& coefficients)
+{
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32) blockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = coefficients.sampleRate;
+
+    if ((int) chains.size() < numChannels)
+        chains.resize((size_t) numChannels);
+
+    pointers.clear();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& chain = chains[(size_t) channel];
+        chain.prepare(spec);
+        applyChainCoefficients(chain, coefficients);
+        pointers.push_back(&chain);
+    }
+
+    buffer.setSize(numChannels, blockSize, false, false, true);
+}
+
+void RenderChains::process(int numSamples) noexcept
+{
+    processFusedChannels(pointers.data(), buffer.getArrayOfWritePointers(), (int) pointers.size(), numSamples);
+}
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(const ChainSettings& s, int numThreads)
+    : settings(s), pool(numThreads)
+{
+    formatManager.registerFormat(new juce::WavAudioFormat(), true);
+    formatManager.registerFormat(new juce::AiffAudioFormat(), false);
+
+    workerChains.resize((size_t) pool.getNumWorkers());
+}
+
+RenderStats OfflineRenderer::renderFiles(const juce::Array<juce::File>& inputs, const juce::File& outputFolder)
+{
+    RenderStats stats;
+    stats.numFiles = inputs.size();
+
+    std::vector<double> audioSeconds((size_t) inputs.size(), 0.0);
+    std::vector<juce::String> errors((size_t) inputs.size());
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    pool.run(inputs.size(), [&](int fileIndex, int workerIndex)
+    {
+        const auto& input = inputs.getReference(fileIndex);
+        renderFile(input, outputFolder.getChildFile(input.getFileName()), workerChains[(size_t) workerIndex],
+                   audioSeconds[(size_t) fileIndex], errors[(size_t) fileIndex]);
+    });
+
+    stats.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    for (size_t i = 0; i < errors.size(); ++i)
+    {
+        if (errors[i].isNotEmpty())
+        {
+            ++stats.numFailed;
+            std::cerr << inputs.getReference((int) i).getFullPathName() << ": " << errors[i] << std::endl;
+        }
+
+        stats.audioSeconds += audioSeconds[i];
+    }
+
+    return stats;
+}
+
+bool OfflineRenderer::renderFile(const juce::File& input, const juce::File& output, RenderChains& chains,
+                                 double& audioSeconds, juce::String& errorMessage)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+    if (format == nullptr)
+    {
+        errorMessage = "unsupported file type";
+        return false;
+    }
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(input));
+
+    if (reader == nullptr)
+    {
+        errorMessage = "couldn't open for reading";
+        return false;
+    }
+
+    const auto numChannels = (int) reader->numChannels;
+    const auto length = reader->lengthInSamples;
+
+    // Render next to the output and move it into place at the end, so an
+    // output that is also an input isn't deleted while it's still mapped.
+    juce::TemporaryFile temporary(output);
+    auto stream = temporary.getFile().createOutputStream();
+
+    if (stream == nullptr)
+    {
+        errorMessage = "couldn't create " + output.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate,
+                                                                            (unsigned int) numChannels, (int) reader->bitsPerSample,
+                                                                            reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        errorMessage = "couldn't create a writer for this format";
+        return false;
+    }
+
+    stream.release(); // now owned by the writer
+
+    chains.prepare(numChannels, chunkSize, makeChainCoefficients(settings, reader->sampleRate));
+
+    // Only one chunk of the input is mapped at a time, so the address space
+    // used stays small however long the file is.
+    for (juce::int64 position = 0; position < length; position += chunkSize)
+    {
+        const auto numSamples = (int) juce::jmin((juce::int64) chunkSize, length - position);
+
+        if (! reader->mapSectionOfFile({ position, position + numSamples })
+            || ! reader->read(chains.buffer.getArrayOfWritePointers(), numChannels, position, numSamples))
+        {
+            errorMessage = "read failed";
+            return false;
+        }
+
+        chains.process(numSamples);
+
+        if (! writer->writeFromAudioSampleBuffer(chains.buffer, 0, numSamples))
+        {
+            errorMessage = "write failed";
+            return false;
+        }
+    }
+
+    audioSeconds = (double) length / reader->sampleRate;
+
+    writer.reset();
+    reader.reset();
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+    {
+        errorMessage = "couldn't replace " + output.getFullPathName();
+        return false;
+    }
+
+    return true;
+}
+
+SegmentStats OfflineRenderer::renderSegmented(const juce::File& input, const juce::File& output,
+                                              const SegmentOptions& options, juce::String& errorMessage)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    SegmentStats stats;
+    stats.numFiles = 1;
+    stats.numFailed = 1;
+
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+    if (format == nullptr)
+    {
+        errorMessage = "unsupported file type";
+        return stats;
+    }
+
+    // Every worker maps its own part of the file through its own reader.
+    const auto numWorkers = pool.getNumWorkers();
+    std::vector<std::unique_ptr<juce::MemoryMappedAudioFormatReader>> readers;
+
+    for (int i = 0; i <= numWorkers; ++i)
+    {
+        readers.emplace_back(format->createMemoryMappedReader(input));
+
+        if (readers.back() == nullptr)
+        {
+            errorMessage = "couldn't open for reading";
+            return stats;
+        }
+    }
+
+    auto& mainReader = *readers.back();
+    const auto numChannels = (int) mainReader.numChannels;
+    const auto length = mainReader.lengthInSamples;
+    const auto sampleRate = mainReader.sampleRate;
+
+    juce::TemporaryFile temporary(output);
+    auto stream = temporary.getFile().createOutputStream();
+
+    if (stream == nullptr)
+    {
+        errorMessage = "couldn't create " + output.getFullPathName();
+        return stats;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate,
+                                                                            (unsigned int) numChannels, (int) mainReader.bitsPerSample,
+                                                                            mainReader.metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        errorMessage = "couldn't create a writer for this format";
+        return stats;
+    }
+
+    stream.release(); // now owned by the writer
+
+    const auto coefficients = makeChainCoefficients(settings, sampleRate);
+    const auto overlap = options.overlapSeconds >= 0 ? (int) std::ceil(options.overlapSeconds * sampleRate)
+                                                     : getDecayLengthInSamples(coefficients, options.toleranceDecibels);
+
+    // Keep the pre-roll a small fraction of the work each segment does.
+    const auto segmentLength = juce::jmax(minSegmentLength, overlap * 8);
+    const auto waveLength = (juce::int64) segmentLength * numWorkers;
+
+    stats.overlapSamples = overlap;
+    stats.numSegments = (int) ((length + segmentLength - 1) / segmentLength);
+
+    std::vector<juce::AudioBuffer<float>> segments((size_t) numWorkers);
+
+    for (auto& segment : segments)
+        segment.setSize(numChannels, segmentLength);
+
+    RenderChains serialChains;
+    double maxError = 0;
+
+    if (options.verify)
+        serialChains.prepare(numChannels, chunkSize, coefficients);
+
+    auto readAndProcess = [&](juce::MemoryMappedAudioFormatReader& reader, RenderChains& chains,
+                              juce::int64 position, int numSamples)
+    {
+        if (! reader.mapSectionOfFile({ position, position + numSamples })
+            || ! reader.read(chains.buffer.getArrayOfWritePointers(), numChannels, position, numSamples))
+            return false;
+
+        chains.process(numSamples);
+        return true;
+    };
+
+    std::atomic<bool> readFailed{ false };
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    double verifyMilliseconds = 0;
+
+    for (juce::int64 waveStart = 0; waveStart < length; waveStart += waveLength)
+    {
+        pool.run(numWorkers, [&](int segmentIndex, int workerIndex)
+        {
+            const auto segmentStart = waveStart + (juce::int64) segmentIndex * segmentLength;
+
+            if (segmentStart >= length)
+                return;
+
+            const auto segmentEnd = juce::jmin(segmentStart + segmentLength, length);
+            auto& chains = workerChains[(size_t) workerIndex];
+            auto& segment = segments[(size_t) segmentIndex];
+
+            chains.prepare(numChannels, chunkSize, coefficients);
+
+            for (auto position = juce::jmax((juce::int64) 0, segmentStart - overlap); position < segmentEnd;)
+            {
+                const auto numSamples = (int) juce::jmin((juce::int64) chunkSize, segmentEnd - position);
+
+                if (! readAndProcess(*readers[(size_t) workerIndex], chains, position, numSamples))
+                {
+                    readFailed = true;
+                    return;
+                }
+
+                // Output from the pre-roll is thrown away.
+                const auto skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, segmentStart - position);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    segment.copyFrom(channel, (int) (position + skip - segmentStart), chains.buffer, channel, skip, numSamples - skip);
+
+                position += numSamples;
+            }
+        });
+
+        if (readFailed)
+        {
+            errorMessage = "read failed";
+            return stats;
+        }
+
+        for (int segmentIndex = 0; segmentIndex < numWorkers; ++segmentIndex)
+        {
+            const auto segmentStart = waveStart + (juce::int64) segmentIndex * segmentLength;
+
+            if (segmentStart >= length)
+                break;
+
+            const auto numSamples = (int) juce::jmin((juce::int64) segmentLength, length - segmentStart);
+            auto& segment = segments[(size_t) segmentIndex];
+
+            if (! writer->writeFromAudioSampleBuffer(segment, 0, numSamples))
+            {
+                errorMessage = "write failed";
+                return stats;
+            }
+
+            if (! options.verify)
+                continue;
+
+            // The serial reference isn't part of the render, so leave it out
+            // of the timing.
+            const auto verifyStart = juce::Time::getMillisecondCounterHiRes();
+
+            for (int offset = 0; offset < numSamples; offset += chunkSize)
+            {
+                const auto numInChunk = juce::jmin(chunkSize, numSamples - offset);
+
+                if (! readAndProcess(mainReader, serialChains, segmentStart + offset, numInChunk))
+                {
+                    errorMessage = "read failed";
+                    return stats;
+                }
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    const auto* expected = serialChains.buffer.getReadPointer(channel);
+                    const auto* actual = segment.getReadPointer(channel, offset);
+
+                    for (int i = 0; i < numInChunk; ++i)
+                        maxError = juce::jmax(maxError, (double) std::abs(actual[i] - expected[i]));
+                }
+            }
+
+            verifyMilliseconds += juce::Time::getMillisecondCounterHiRes() - verifyStart;
+        }
+    }
+
+    stats.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime - verifyMilliseconds) * 0.001;
+    stats.audioSeconds = (double) length / sampleRate;
+
+    writer.reset();
+    readers.clear();
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+    {
+        errorMessage = "couldn't replace " + output.getFullPathName();
+        return stats;
+    }
+
+    stats.numFailed = 0;
+
+    if (options.verify)
+        stats.maxErrorDecibels = maxError > 0 ? juce::Decibels::gainToDecibels(maxError, -400.0)
+                                              : -std::numeric_limits<double>::infinity();
+
+    return stats;
+}
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+    Runs the EQ's filter chain over audio files without a host.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../FilterChain.h"
+#include "../WorkStealingPool.h"
+
+/** The plugin's parameter defaults, from ParameterTable.h. */
+ChainSettings getDefaultChainSettings();
+
+/** Reads the EQ settings from a state saved by the plugin: the compact state
+    written by getStateInformation(), or the binary ValueTree earlier versions
+    wrote, or its XML form. Parameters missing from the state keep their
+    current value in settings.
+*/
+bool loadChainSettings(const juce::File& presetFile, ChainSettings& settings);
+
+struct RenderStats
+{
+    int numFiles{ 0 }, numFailed{ 0 };
+    double audioSeconds{ 0 }, wallSeconds{ 0 };
+
+    double getFilesPerSecond() const noexcept { return wallSeconds > 0 ? (numFiles - numFailed) / wallSeconds : 0; }
+    double getRealtimeFactor() const noexcept { return wallSeconds > 0 ? audioSeconds / wallSeconds : 0; }
+};
+
+/** Options for rendering one long file in parallel segments. */
+struct SegmentOptions
+{
+    /** Pre-roll before each segment in seconds, or negative to size it from
+        the chain's decay time at toleranceDecibels.
+    */
+    double overlapSeconds{ -1 };
+    double toleranceDecibels{ -120 };
+    /** Also render the file serially and report the largest difference. */
+    bool verify{ false };
+};
+
+struct SegmentStats : RenderStats
+{
+    int numSegments{ 0 }, overlapSamples{ 0 };
+    /** Largest difference from a serial render, or -inf if not verified. */
+    double maxErrorDecibels{ -std::numeric_limits<double>::infinity() };
+};
+
+/** One set of chains, reused for every file a worker renders. */
+struct RenderChains
+{
+    std::vector<MonoChain> chains;
+    std::vector<MonoChain*> pointers;
+    juce::AudioBuffer<float> buffer;
+
+    /** Resets the chains and configures them for a file. */
+    void prepare(int numChannels, int blockSize, const ChainCoefficients& coefficients);
+    void process(int numSamples) noexcept;
+};
+
+/**
+    Renders WAV and AIFF files through the EQ, spreading the files over a
+    work-stealing pool with one RenderChains per worker. Input is read through
+    memory-mapped chunks and output written in the input's format and bit depth.
+*/
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer(const ChainSettings& settings, int numThreads = 0);
+
+    /** Renders every input into outputFolder under the same file name. Each
+        output is written to a temporary file first, so the folder may be the
+        one the inputs are in.
+    */
+    RenderStats renderFiles(const juce::Array<juce::File>& inputs, const juce::File& outputFolder);
+
+    /** Renders one file on the calling thread. Returns false and leaves an
+        error in errorMessage if it can't be read or written.
+    */
+    bool renderFile(const juce::File& input, const juce::File& output, RenderChains& chains,
+                    double& audioSeconds, juce::String& errorMessage);
+
+    /** Renders a single file by splitting it into segments that are processed
+        on all workers at once. Each worker first runs its chains over the
+        overlap before its segment so the filter state has settled by the
+        time output starts; the remaining error is bounded by the tolerance
+        the overlap was sized for.
+    */
+    SegmentStats renderSegmented(const juce::File& input, const juce::File& output,
+                                 const SegmentOptions& options, juce::String& errorMessage);
+
+    static constexpr int chunkSize = 1 << 16;
+    static constexpr int minSegmentLength = 1 << 18;
+
+private:
+    ChainSettings settings;
+    juce::AudioFormatManager formatManager;
+    WorkStealingPool pool;
+    std::vector<RenderChains> workerChains;
+
+    JUCE_DECLARE_NON_COPYABLE(OfflineRenderer)
+};
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    BenchmarkHarness.h
+
+    Timing and result collection shared by the benchmark sections.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+/** The CPU's time stamp counter where there is one, otherwise 0. */
+inline juce::uint64 readCycleCounter() noexcept
+{
+   #if JUCE_INTEL
+    return (juce::uint64) __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+/** Time and cycles taken by one call of the measured function. */
+struct Measurement
+{
+    double nanoseconds{ 0 }, cycles{ 0 };
+};
+
+/** Calls fn iterations times per run and returns the median of several runs,
+    after one untimed warm-up run.
+*/
+template <typename Function>
+Measurement measure(int iterations, Function&& fn, int numRuns = 5)
+{
+    for (int i = 0; i < iterations; ++i)
+        fn();
+
+    std::vector<Measurement> runs;
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+
+        for (int i = 0; i < iterations; ++i)
+            fn();
+
+        const auto cycles = (double) (readCycleCounter() - startCycles);
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        runs.push_back({ seconds * 1.0e9 / iterations, cycles / iterations });
+    }
+
+    std::sort(runs.begin(), runs.end(), [](auto& a, auto& b) { return a.nanoseconds < b.nanoseconds; });
+    return runs[runs.size() / 2];
+}
+
+/** Keeps the compiler from optimising away a result nobody reads. */
+template <typename Type>
+void doNotOptimise(const Type& value) noexcept
+{
+    static volatile char sink;
+    sink = *reinterpret_cast<const volatile char*>(&value);
+}
+
+/** Collects results as a JSON array of flat objects, and echoes them as text. */
+class BenchmarkResults
+{
+public:
+    void add(const juce::String& benchmark, const juce::NamedValueSet& values)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("benchmark", benchmark);
+
+        juce::String line = benchmark;
+
+        for (const auto& value : values)
+        {
+            object->setProperty(value.name, value.value);
+            line << "  " << value.name.toString() << "=" << value.value.toString();
+        }
+
+        results.add(juce::var(object));
+        std::cout << line << std::endl;
+    }
+
+    juce::String toJSON() const
+    {
+        return juce::JSON::toString(juce::var(results));
+    }
+
+private:
+    juce::Array<juce::var> results;
+};
@@ -0,0 +1,995 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs NewProjectAudioProcessor and the filter design functions without a
+    host and reports their cost.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BenchmarkHarness.h"
+#include "../PluginProcessor.h"
+#include "../CascadeKernel.h"
+#include "../SpectrumAnalyser.h"
+#include "../SvfFilter.h"
+#include "../LinearPhaseConvolver.h"
+#include "../BandGraph.h"
+#include "../PresetBank.h"
+#include "../RealtimeSanitizer.h"
+#include "../TimeParallelKernel.h"
+#include "../ParallelForm.h"
+#include "../ChainBatch.h"
+#include "../DesignMath.h"
+
+namespace
+{
+    const Slope allSlopes[] = { Slope_12, Slope_24, Slope_36, Slope_48 };
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    int getSlopeInDecibels(Slope slope) { return 12 * (slope + 1); }
+
+    ChainSettings makeSettings(Slope slope)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.f;
+        settings.highCutFreq = 12000.f;
+        settings.peakFreq = 1000.f;
+        settings.peakGaininDecibels = 6.f;
+        settings.peakQuality = 1.f;
+        settings.lowCutSlope = slope;
+        settings.highCutSlope = slope;
+        return settings;
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random(1);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+    }
+
+    //==============================================================================
+    void runDesignBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int iterations = 20000;
+        const auto sampleRate = 48000.0;
+
+        for (auto slope : allSlopes)
+        {
+            auto settings = makeSettings(slope);
+            int call = 0;
+
+            // Nudge the frequency each call so nothing can be hoisted. Cuts at
+            // fractional frequencies bypass CutDesignCache, so these measure
+            // the design itself; the whole-Hz runs below measure cache hits.
+            auto peak = measure(iterations, [&] { settings.peakFreq = 1000.f + (float) (++call & 255); doNotOptimise(makePeakFilter(settings, sampleRate)); });
+            auto lowCut = measure(iterations, [&] { settings.lowCutFreq = 80.5f + (float) (++call & 255); doNotOptimise(makeLowCutFilter(settings, sampleRate)); });
+            auto highCut = measure(iterations, [&] { settings.highCutFreq = 12000.5f + (float) (++call & 255); doNotOptimise(makeHighCutFilter(settings, sampleRate)); });
+            auto lowCutCached = measure(iterations, [&] { settings.lowCutFreq = 80.f + (float) (++call & 255); doNotOptimise(makeLowCutFilter(settings, sampleRate)); });
+
+            const auto cutCoefficients = makeLowCutFilter(settings, sampleRate);
+            CutFilter cut;
+            auto update = measure(iterations, [&] { updateCutFilter(cut, cutCoefficients, slope); doNotOptimise(cut); });
+
+            results.add("makePeakFilter", { { "slope", getSlopeInDecibels(slope) }, { "nsPerCall", peak.nanoseconds } });
+            results.add("makeLowCutFilter", { { "slope", getSlopeInDecibels(slope) }, { "nsPerCall", lowCut.nanoseconds } });
+            results.add("makeHighCutFilter", { { "slope", getSlopeInDecibels(slope) }, { "nsPerCall", highCut.nanoseconds } });
+            results.add("makeLowCutFilterCached", { { "slope", getSlopeInDecibels(slope) }, { "nsPerCall", lowCutCached.nanoseconds } });
+            results.add("updateCutFilter", { { "slope", getSlopeInDecibels(slope) }, { "nsPerCall", update.nanoseconds } });
+        }
+    }
+
+    //==============================================================================
+    float getMaxCoefficientDifference(const BiquadCoefficients& a, const BiquadCoefficients& b)
+    {
+        return juce::jmax(std::abs(a.b0 - b.b0), std::abs(a.b1 - b.b1), std::abs(a.b2 - b.b2),
+                          juce::jmax(std::abs(a.a1 - b.a1), std::abs(a.a2 - b.a2)));
+    }
+
+    float getMaxCoefficientDifference(const ChainCoefficients& a, const ChainCoefficients& b)
+    {
+        auto difference = getMaxCoefficientDifference(a.peak, b.peak);
+
+        for (int stage = 0; stage < a.lowCut.numStages; ++stage)
+            difference = juce::jmax(difference, getMaxCoefficientDifference(a.lowCut.stages[(size_t) stage], b.lowCut.stages[(size_t) stage]));
+
+        for (int stage = 0; stage < a.highCut.numStages; ++stage)
+            difference = juce::jmax(difference, getMaxCoefficientDifference(a.highCut.stages[(size_t) stage], b.highCut.stages[(size_t) stage]));
+
+        return difference;
+    }
+
+    void runFastDesignBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int numChains = 256;
+        constexpr int iterations = 200;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto slope : allSlopes)
+            {
+                // Spread over every band's range, at fractional frequencies so
+                // the reference misses CutDesignCache as a glide would.
+                std::vector<ChainSettings> settings((size_t) numChains, makeSettings(slope));
+                juce::Random random(1);
+
+                for (auto& s : settings)
+                {
+                    s.lowCutFreq = 20.f * std::pow(100.f, random.nextFloat()) + 0.5f;
+                    s.highCutFreq = 200.f * std::pow(100.f, random.nextFloat()) + 0.5f;
+                    s.peakFreq = 20.f * std::pow(1000.f, random.nextFloat());
+                    s.peakGaininDecibels = random.nextFloat() * 48.f - 24.f;
+                    s.peakQuality = 0.1f + random.nextFloat() * 9.9f;
+                }
+
+                std::vector<ChainCoefficients> reference((size_t) numChains), fast((size_t) numChains);
+
+                auto referenceTime = measure(iterations, [&]
+                {
+                    for (int i = 0; i < numChains; ++i)
+                        reference[(size_t) i] = makeChainCoefficients(settings[(size_t) i], sampleRate);
+
+                    doNotOptimise(reference.back());
+                });
+
+                auto batchTime = measure(iterations, [&]
+                {
+                    makeChainCoefficientsBatch(settings.data(), sampleRate, fast.data(), numChains);
+                    doNotOptimise(fast.back());
+                });
+
+                auto maxDifference = 0.f;
+
+                for (int i = 0; i < numChains; ++i)
+                    maxDifference = juce::jmax(maxDifference, getMaxCoefficientDifference(reference[(size_t) i], fast[(size_t) i]));
+
+                const auto referenceNs = referenceTime.nanoseconds / numChains;
+                const auto batchNs = batchTime.nanoseconds / numChains;
+
+                results.add("fastDesign", { { "sampleRate", sampleRate },
+                                            { "slope", getSlopeInDecibels(slope) },
+                                            { "referenceNsPerChain", referenceNs },
+                                            { "batchNsPerChain", batchNs },
+                                            { "referenceDesignsPerSecond", 1.0e9 / referenceNs },
+                                            { "batchDesignsPerSecond", 1.0e9 / batchNs },
+                                            { "maxCoefficientDifference", maxDifference } });
+            }
+        }
+    }
+
+    //==============================================================================
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterID, float value)
+    {
+        auto* parameter = apvts.getParameter(parameterID);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void runProcessBlockBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int samplesPerRun = 1 << 15;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                for (auto slope : allSlopes)
+                {
+                    for (auto automated : { false, true })
+                    {
+                        NewProjectAudioProcessor processor;
+                        auto& apvts = processor.apvts;
+                        const auto settings = makeSettings(slope);
+
+                        setParameter(apvts, "LowCut Freq", settings.lowCutFreq);
+                        setParameter(apvts, "HighCut Freq", settings.highCutFreq);
+                        setParameter(apvts, "Peak Freq", settings.peakFreq);
+                        setParameter(apvts, "Peak Gain", settings.peakGaininDecibels);
+                        setParameter(apvts, "LowCut Slope", (float) slope);
+                        setParameter(apvts, "HighCut Slope", (float) slope);
+
+                        // There's no message loop here, so automated runs
+                        // render offline; that way each change is designed
+                        // inside processBlock and shows up in its cost.
+                        processor.setNonRealtime(automated);
+                        processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+                        processor.prepareToPlay(sampleRate, blockSize);
+
+                        juce::AudioBuffer<float> buffer(2, blockSize);
+                        juce::MidiBuffer midi;
+                        fillWithNoise(buffer);
+
+                        auto* sweptParameter = apvts.getParameter("LowCut Freq");
+                        int block = 0;
+
+                        auto m = measure(juce::jmax(1, samplesPerRun / blockSize), [&]
+                        {
+                            if (automated)
+                                sweptParameter->setValueNotifyingHost(0.1f + 0.2f * (float) ((++block & 63) / 63.0));
+
+                            processor.processBlock(buffer, midi);
+                        });
+
+                        results.add("processBlock", { { "sampleRate", sampleRate },
+                                                      { "blockSize", blockSize },
+                                                      { "slope", getSlopeInDecibels(slope) },
+                                                      { "automated", automated },
+                                                      { "nsPerSample", m.nanoseconds / blockSize },
+                                                      { "cyclesPerBlock", m.cycles } });
+
+                        processor.releaseResources();
+                    }
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // The cost of each oversampling factor at the rates where it matters.
+    void runOversamplingBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int samplesPerRun = 1 << 16;
+        constexpr int blockSize = 512;
+
+        for (auto sampleRate : { 44100.0, 48000.0 })
+        {
+            for (auto slope : allSlopes)
+            {
+                for (int order = 0; order <= NewProjectAudioProcessor::maxOversamplingOrder; ++order)
+                {
+                    NewProjectAudioProcessor processor;
+                    setParameter(processor.apvts, "LowCut Slope", (float) slope);
+                    setParameter(processor.apvts, "HighCut Slope", (float) slope);
+                    setParameter(processor.apvts, "HighCut Freq", 12000.f);
+                    setParameter(processor.apvts, "Oversampling", (float) order);
+
+                    processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+                    processor.prepareToPlay(sampleRate, blockSize);
+
+                    juce::AudioBuffer<float> buffer(2, blockSize);
+                    juce::MidiBuffer midi;
+                    fillWithNoise(buffer);
+
+                    auto m = measure(samplesPerRun / blockSize, [&] { processor.processBlock(buffer, midi); });
+
+                    results.add("oversampling", { { "sampleRate", sampleRate },
+                                                  { "slope", getSlopeInDecibels(slope) },
+                                                  { "factor", 1 << order },
+                                                  { "latencySamples", processor.getLatencySamples() },
+                                                  { "nsPerSample", m.nanoseconds / blockSize } });
+
+                    processor.releaseResources();
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // The chain worked out in double precision, from the ideal designs rather
+    // than rounded float coefficients, to measure each engine's error against.
+    void processReference(const ChainSettings& settings, double sampleRate, std::vector<double>& samples)
+    {
+        struct Section { double g, k, m0, m1, m2, ic1eq = 0, ic2eq = 0; };
+        std::vector<Section> sections;
+        const auto pi = juce::MathConstants<double>::pi;
+
+        auto addCut = [&](double frequency, Slope slope, bool isHighpass)
+        {
+            const auto numStages = (int) slope + 1;
+            const auto g = std::tan(pi * frequency / sampleRate);
+
+            for (int i = 0; i < numStages; ++i)
+            {
+                const auto k = 2.0 * std::cos((2.0 * i + 1.0) * pi / (numStages * 4.0));
+                sections.push_back(isHighpass ? Section{ g, k, 1.0, -k, -1.0 } : Section{ g, k, 0.0, 0.0, 1.0 });
+            }
+        };
+
+        addCut(settings.lowCutFreq, settings.lowCutSlope, true);
+
+        const auto A = std::pow(10.0, settings.peakGaininDecibels / 40.0);
+        const auto peakK = 1.0 / (settings.peakQuality * A);
+        sections.push_back({ std::tan(pi * settings.peakFreq / sampleRate), peakK, 1.0, peakK * (A * A - 1.0), 0.0 });
+
+        addCut(settings.highCutFreq, settings.highCutSlope, false);
+
+        for (auto& sample : samples)
+        {
+            for (auto& s : sections)
+            {
+                const auto a1 = 1.0 / (1.0 + s.g * (s.g + s.k));
+                const auto a2 = s.g * a1, a3 = s.g * a2;
+                const auto v3 = sample - s.ic2eq;
+                const auto v1 = a1 * s.ic1eq + a2 * v3;
+                const auto v2 = s.ic2eq + a2 * s.ic1eq + a3 * v3;
+
+                s.ic1eq = 2.0 * v1 - s.ic1eq;
+                s.ic2eq = 2.0 * v2 - s.ic2eq;
+                sample = s.m0 * sample + s.m1 * v1 + s.m2 * v2;
+            }
+        }
+    }
+
+    // Biquads against SVFs on one channel: cost, and error relative to the
+    // double precision reference, with the low cut just above 20 Hz since
+    // that's where float biquads struggle most.
+    void runSvfBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int blockSize = 512;
+
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto slope : allSlopes)
+            {
+                auto settings = makeSettings(slope);
+                settings.lowCutFreq = 21.f;
+
+                const auto numSamples = (int) sampleRate;
+                juce::AudioBuffer<float> noise(1, numSamples);
+                fillWithNoise(noise);
+
+                MonoChain chain;
+                applyChainCoefficients(chain, makeChainCoefficients(settings, sampleRate));
+                SvfChain svfChain;
+                svfChain.setCoefficients(makeSvfChainCoefficients(settings, sampleRate));
+
+                juce::AudioBuffer<float> block(1, blockSize);
+                fillWithNoise(block);
+                const auto iterations = (1 << 16) / blockSize;
+
+                auto biquadTime = measure(iterations, [&] { processFused(chain, block.getWritePointer(0), blockSize); });
+                auto svfTime = measure(iterations, [&] { svfChain.process(block.getWritePointer(0), blockSize); });
+
+                // Fresh state for the accuracy run.
+                chain.reset();
+                svfChain.reset();
+
+                std::vector<double> reference(noise.getReadPointer(0), noise.getReadPointer(0) + numSamples);
+                processReference(settings, sampleRate, reference);
+
+                juce::AudioBuffer<float> biquadOutput(noise), svfOutput(noise);
+                processFused(chain, biquadOutput.getWritePointer(0), numSamples);
+                svfChain.process(svfOutput.getWritePointer(0), numSamples);
+
+                auto getErrorInDecibels = [&](const juce::AudioBuffer<float>& output)
+                {
+                    double error = 0, power = 0;
+
+                    for (int i = 0; i < numSamples; ++i)
+                    {
+                        const auto difference = output.getSample(0, i) - reference[(size_t) i];
+                        error += difference * difference;
+                        power += reference[(size_t) i] * reference[(size_t) i];
+                    }
+
+                    return 10.0 * std::log10(juce::jmax(error, 1.0e-30) / power);
+                };
+
+                results.add("svf", { { "sampleRate", sampleRate },
+                                     { "slope", getSlopeInDecibels(slope) },
+                                     { "biquadNsPerSample", biquadTime.nanoseconds / blockSize },
+                                     { "svfNsPerSample", svfTime.nanoseconds / blockSize },
+                                     { "biquadErrorDecibels", getErrorInDecibels(biquadOutput) },
+                                     { "svfErrorDecibels", getErrorInDecibels(svfOutput) } });
+            }
+        }
+    }
+
+    //==============================================================================
+    // The linear phase engine against the IIR path, per channel. The FIR's
+    // cost depends only on the sample rate, whatever the slopes.
+    void runLinearPhaseBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int blockSize = 512;
+        const auto iterations = (1 << 17) / blockSize;
+
+        for (auto sampleRate : { 48000.0, 96000.0 })
+        {
+            LinearPhaseConvolver convolver;
+            convolver.prepare(sampleRate, 1);
+
+            for (auto slope : allSlopes)
+            {
+                const auto coefficients = makeChainCoefficients(makeSettings(slope), sampleRate);
+                MonoChain chain;
+                applyChainCoefficients(chain, coefficients);
+                convolver.requestKernels(&coefficients, 1, true);
+
+                juce::AudioBuffer<float> block(1, blockSize);
+                fillWithNoise(block);
+                const int kernelIndex = 0;
+
+                auto iirTime = measure(iterations, [&] { processFused(chain, block.getWritePointer(0), blockSize); });
+                auto firTime = measure(iterations, [&] { convolver.process(block.getArrayOfWritePointers(), &kernelIndex, 1, blockSize); });
+
+                results.add("linearPhase", { { "sampleRate", sampleRate },
+                                             { "slope", getSlopeInDecibels(slope) },
+                                             { "kernelLength", convolver.getKernelLength() },
+                                             { "latencySamples", convolver.getLatencyInSamples() },
+                                             { "iirNsPerSample", iirTime.nanoseconds / blockSize },
+                                             { "linearPhaseNsPerSample", firTime.nanoseconds / blockSize } });
+            }
+        }
+    }
+
+    //==============================================================================
+    // The Band Graph engine's cost as bands are added, with both cuts at
+    // 96 dB/oct, against the fixed chain at its steepest.
+    void runBandGraphBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int blockSize = 512;
+        const auto iterations = (1 << 17) / blockSize;
+        const auto sampleRate = 48000.0;
+
+        juce::AudioBuffer<float> block(1, blockSize);
+        fillWithNoise(block);
+
+        MonoChain chain;
+        applyChainCoefficients(chain, makeChainCoefficients(makeSettings(Slope_48), sampleRate));
+        auto chainTime = measure(iterations, [&] { processFused(chain, block.getWritePointer(0), blockSize); });
+
+        for (auto numBands : { 1, 4, 8, 12, 16, 24 })
+        {
+            BandGraphSettings settings;
+            applyChainSettings(settings, makeSettings(Slope_48));
+            settings.lowCutStages = settings.highCutStages = maxButterworthStages;
+
+            for (int i = 1; i < numBands; ++i)
+                settings.bands[(size_t) i] = { BandType::peak, 30.f * std::pow(500.f, (float) i / (float) maxGraphBands), 3.f, 2.f };
+
+            BandGraph graph;
+            const auto coefficients = makeBandGraphCoefficients(settings, sampleRate);
+            graph.setCoefficients(coefficients);
+
+            auto graphTime = measure(iterations, [&] { graph.process(block.getWritePointer(0), blockSize); });
+
+            results.add("bandGraph", { { "numBands", numBands },
+                                       { "numSections", coefficients.numSections },
+                                       { "chainNsPerSample", chainTime.nanoseconds / blockSize },
+                                       { "graphNsPerSample", graphTime.nanoseconds / blockSize },
+                                       { "graphNsPerSection", graphTime.nanoseconds / blockSize / coefficients.numSections } });
+        }
+    }
+
+    //==============================================================================
+    // Opening a session: making N instances, then restoring each one's state
+    // through replaceState() as earlier versions did, then through
+    // setStateInformation() from the ValueTree they saved and from a compact
+    // state, and from a shared, memory-mapped preset bank.
+    void runSessionLoadBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int numPresets = 8;
+        const auto sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        // The states to restore, saved from one instance as earlier versions
+        // did (the ValueTree alone) and as this one does (with the compact
+        // state after it).
+        NewProjectAudioProcessor source;
+        std::vector<juce::MemoryBlock> valueTreeStates, compactStates;
+        std::vector<std::vector<float>> presetValues;
+        juce::StringArray presetNames;
+
+        for (int i = 0; i < numPresets; ++i)
+        {
+            source.apvts.getParameter("Peak Freq")->setValueNotifyingHost((float) (i + 1) / (float) (numPresets + 1));
+            source.apvts.getParameter("Peak Gain")->setValueNotifyingHost(0.25f + 0.5f * (float) (i & 1));
+            source.apvts.getParameter("LowCut Slope")->setValueNotifyingHost((float) (i % 4) / 3.f);
+
+            juce::MemoryOutputStream valueTreeState;
+            source.apvts.copyState().writeToStream(valueTreeState);
+            valueTreeStates.push_back(valueTreeState.getMemoryBlock());
+
+            compactStates.emplace_back();
+            source.getStateInformation(compactStates.back());
+
+            presetValues.push_back(source.getParameterState().getPlainValues());
+            presetNames.add("Preset " + juce::String(i + 1));
+        }
+
+        const auto bankFile = juce::File::createTempFile(".eqbank");
+        PresetBank::write(bankFile, source.getParameterState().getIdHashes(), presetNames, presetValues);
+
+        // Kept open, as the first instance to load from it would, so the
+        // others share its mapping.
+        const auto firstBank = PresetBank::open(bankFile);
+
+        for (auto numInstances : { 1, 16, 64, 256 })
+        {
+            std::vector<std::unique_ptr<NewProjectAudioProcessor>> processors;
+            auto seconds = [](juce::int64 startTicks)
+            {
+                return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            };
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                processors.push_back(std::make_unique<NewProjectAudioProcessor>());
+                processors.back()->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+            }
+
+            const auto instantiate = seconds(start);
+
+            // Each pass starts one preset further on, so every instance has
+            // parameters to change.
+            int offset = 0;
+
+            auto restore = [&](auto&& restoreOne)
+            {
+                ++offset;
+                start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numInstances; ++i)
+                    restoreOne(*processors[(size_t) i], (i + offset) % numPresets);
+
+                return seconds(start);
+            };
+
+            // What setStateInformation() used to do, less the design it then
+            // ran straight away.
+            const auto replaceState = restore([&](NewProjectAudioProcessor& p, int preset)
+            {
+                const auto& state = valueTreeStates[(size_t) preset];
+                p.apvts.replaceState(juce::ValueTree::readFromData(state.getData(), state.getSize()));
+            });
+
+            const auto valueTree = restore([&](NewProjectAudioProcessor& p, int preset)
+            {
+                const auto& state = valueTreeStates[(size_t) preset];
+                p.setStateInformation(state.getData(), (int) state.getSize());
+            });
+
+            const auto compact = restore([&](NewProjectAudioProcessor& p, int preset)
+            {
+                const auto& state = compactStates[(size_t) preset];
+                p.setStateInformation(state.getData(), (int) state.getSize());
+            });
+
+            const auto bankRestore = restore([&](NewProjectAudioProcessor& p, int preset)
+            {
+                // Every instance still opens the bank itself.
+                if (auto bank = PresetBank::open(bankFile))
+                    p.loadPreset(*bank, preset);
+            });
+
+            results.add("sessionLoad", { { "numInstances", numInstances },
+                                         { "valueTreeBytes", (int) valueTreeStates[0].getSize() },
+                                         { "compactBytes", (int) compactStates[0].getSize() },
+                                         { "instantiateUsPerInstance", instantiate * 1.0e6 / numInstances },
+                                         { "replaceStateUsPerInstance", replaceState * 1.0e6 / numInstances },
+                                         { "valueTreeRestoreUsPerInstance", valueTree * 1.0e6 / numInstances },
+                                         { "compactRestoreUsPerInstance", compact * 1.0e6 / numInstances },
+                                         { "presetBankRestoreUsPerInstance", bankRestore * 1.0e6 / numInstances } });
+        }
+
+        bankFile.deleteFile();
+    }
+
+    //==============================================================================
+    // Reading the parameters: every one looked up by id, as getChainSettings()
+    // used to for its seven, against one pass over the cached pointers, and
+    // the generation compare that usually makes even that unnecessary.
+    void runParameterReadBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int iterations = 20000;
+
+        NewProjectAudioProcessor processor;
+        CachedParameters cachedParameters(processor.apvts);
+        ParameterSnapshot snapshot;
+
+        juce::StringArray ids;
+
+        for (int index = 0; index < numParameters; ++index)
+            ids.add(getParameterID(index));
+
+        const auto lookup = measure(iterations, [&]
+        {
+            for (int index = 0; index < numParameters; ++index)
+                snapshot.values[(size_t) index] = processor.apvts.getRawParameterValue(ids[index])->load();
+
+            doNotOptimise(snapshot);
+        });
+
+        const auto cached = measure(iterations, [&]
+        {
+            cachedParameters.read(snapshot);
+            doNotOptimise(snapshot);
+        });
+
+        const auto compare = measure(iterations, [&]
+        {
+            doNotOptimise(cachedParameters.getGeneration() != snapshot.generation);
+        });
+
+        results.add("parameterRead", { { "numParameters", numParameters },
+                                       { "lookupNsPerRead", lookup.nanoseconds },
+                                       { "cachedNsPerRead", cached.nanoseconds },
+                                       { "generationCompareNs", compare.nanoseconds } });
+    }
+
+    //==============================================================================
+    // What feeding the analyser adds to processBlock, with its consumer thread
+    // running as it would be while an editor is open.
+    void runAnalyserBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int samplesPerRun = 1 << 16;
+        const auto sampleRate = 48000.0;
+
+        for (auto blockSize : { 32, 128, 512 })
+        {
+            NewProjectAudioProcessor processor;
+            processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            SpectrumAnalyser analyser({ &processor.getPreEqFifo(), &processor.getPostEqFifo() });
+            analyser.setSampleRate(sampleRate);
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::MidiBuffer midi;
+            fillWithNoise(buffer);
+
+            const auto iterations = samplesPerRun / blockSize;
+
+            processor.setAnalyserEnabled(false);
+            auto disabled = measure(iterations, [&] { processor.processBlock(buffer, midi); });
+
+            analyser.start({});
+            processor.setAnalyserEnabled(true);
+            auto enabled = measure(iterations, [&] { processor.processBlock(buffer, midi); });
+            analyser.stop();
+
+            results.add("analyser", { { "blockSize", blockSize },
+                                      { "disabledNsPerSample", disabled.nanoseconds / blockSize },
+                                      { "enabledNsPerSample", enabled.nanoseconds / blockSize },
+                                      { "overheadPercent", 100.0 * (enabled.nanoseconds / disabled.nanoseconds - 1.0) } });
+
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // Stereo through the SIMD lane kernel against two separate chains.
+    void runStereoKernelBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int samplesPerRun = 1 << 16;
+        const auto sampleRate = 48000.0;
+
+        for (auto slope : allSlopes)
+        {
+            const auto coefficients = makeChainCoefficients(makeSettings(slope), sampleRate);
+
+            for (auto blockSize : { 32, 128, 1024 })
+            {
+                MonoChain left, right;
+                applyChainCoefficients(left, coefficients);
+                applyChainCoefficients(right, coefficients);
+
+                MonoChain* chains[] = { &left, &right };
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                fillWithNoise(buffer);
+
+                const auto iterations = samplesPerRun / blockSize;
+
+                auto separate = measure(iterations, [&]
+                {
+                    processFused(left, buffer.getWritePointer(0), blockSize);
+                    processFused(right, buffer.getWritePointer(1), blockSize);
+                });
+
+                auto linked = measure(iterations, [&]
+                {
+                    processFusedLanes(chains, buffer.getArrayOfWritePointers(), 2, blockSize);
+                });
+
+                results.add("stereoKernel", { { "slope", getSlopeInDecibels(slope) },
+                                              { "blockSize", blockSize },
+                                              { "separateNsPerSample", separate.nanoseconds / blockSize },
+                                              { "linkedNsPerSample", linked.nanoseconds / blockSize } });
+            }
+        }
+    }
+
+    // One channel three ways: a pass over the block per section, as the
+    // chain's own process() does; the fused kernel, one sample after another;
+    // and the time-parallel kernel. The error of the last two is measured
+    // against the double precision reference.
+    void runTimeParallelBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int samplesPerRun = 1 << 16;
+        const auto sampleRate = 48000.0;
+
+        for (auto slope : allSlopes)
+        {
+            const auto settings = makeSettings(slope);
+            const auto coefficients = makeChainCoefficients(settings, sampleRate);
+
+            for (auto blockSize : { 32, 128, 1024 })
+            {
+                MonoChain chain;
+                applyChainCoefficients(chain, coefficients);
+                TimeParallelCascade cascade;
+                makeTimeParallelCascade(cascade, chain);
+
+                juce::AudioBuffer<float> buffer(1, blockSize);
+                fillWithNoise(buffer);
+
+                const auto iterations = samplesPerRun / blockSize;
+
+                auto perSection = measure(iterations, [&]
+                {
+                    juce::dsp::AudioBlock<float> block(buffer);
+                    chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+                });
+
+                auto fused = measure(iterations, [&] { processFused(chain, buffer.getWritePointer(0), blockSize); });
+                auto timeParallel = measure(iterations, [&] { processTimeParallel(chain, cascade, buffer.getWritePointer(0), blockSize); });
+
+                results.add("timeParallel", { { "slope", getSlopeInDecibels(slope) },
+                                              { "blockSize", blockSize },
+                                              { "numSections", cascade.numSections },
+                                              { "perSectionNsPerSample", perSection.nanoseconds / blockSize },
+                                              { "fusedNsPerSample", fused.nanoseconds / blockSize },
+                                              { "timeParallelNsPerSample", timeParallel.nanoseconds / blockSize } });
+            }
+
+            // A second of noise, in blocks of an awkward size so the kernel's
+            // leftover samples are covered too.
+            const auto numSamples = (int) sampleRate;
+            juce::AudioBuffer<float> noise(1, numSamples);
+            fillWithNoise(noise);
+
+            std::vector<double> reference(noise.getReadPointer(0), noise.getReadPointer(0) + numSamples);
+            processReference(settings, sampleRate, reference);
+
+            MonoChain fusedChain, timeParallelChain;
+            applyChainCoefficients(fusedChain, coefficients);
+            applyChainCoefficients(timeParallelChain, coefficients);
+            TimeParallelCascade cascade;
+            makeTimeParallelCascade(cascade, timeParallelChain);
+
+            juce::AudioBuffer<float> fusedOutput(noise), timeParallelOutput(noise);
+
+            for (int start = 0; start < numSamples; start += 509)
+            {
+                const auto numInBlock = juce::jmin(509, numSamples - start);
+                processFused(fusedChain, fusedOutput.getWritePointer(0, start), numInBlock);
+                processTimeParallel(timeParallelChain, cascade, timeParallelOutput.getWritePointer(0, start), numInBlock);
+            }
+
+            auto getErrorInDecibels = [&](const juce::AudioBuffer<float>& output)
+            {
+                double error = 0, power = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto difference = output.getSample(0, i) - reference[(size_t) i];
+                    error += difference * difference;
+                    power += reference[(size_t) i] * reference[(size_t) i];
+                }
+
+                return 10.0 * std::log10(juce::jmax(error, 1.0e-30) / power);
+            };
+
+            results.add("timeParallelError", { { "slope", getSlopeInDecibels(slope) },
+                                               { "fusedErrorDecibels", getErrorInDecibels(fusedOutput) },
+                                               { "timeParallelErrorDecibels", getErrorInDecibels(timeParallelOutput) } });
+        }
+    }
+
+    // One channel run as the fused cascade and as its parallel form, for low
+    // cuts from the bottom of the range up, since that's where the parallel
+    // form runs out of precision. The error is against the cascade's output.
+    void runParallelFormBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int blockSize = 256;
+        constexpr int iterations = (1 << 16) / blockSize;
+        const auto sampleRate = 48000.0;
+
+        for (auto slope : allSlopes)
+        {
+            for (auto lowCutFreq : { 25.f, 40.f, 80.f, 200.f })
+            {
+                auto settings = makeSettings(slope);
+                settings.lowCutFreq = lowCutFreq;
+                const auto coefficients = makeChainCoefficients(settings, sampleRate);
+
+                auto design = measure(1000, [&] { doNotOptimise(makeParallelCoefficients(coefficients)); });
+
+                const auto parallel = makeParallelCoefficients(coefficients);
+
+                MonoChain chain;
+                applyChainCoefficients(chain, coefficients);
+                ParallelChain parallelChain;
+                parallelChain.setCoefficients(parallel);
+
+                juce::AudioBuffer<float> buffer(1, blockSize);
+                fillWithNoise(buffer);
+
+                auto fused = measure(iterations, [&] { processFused(chain, buffer.getWritePointer(0), blockSize); });
+                auto parallelTime = measure(iterations, [&] { parallelChain.process(buffer.getWritePointer(0), blockSize); });
+
+                // Fresh state for the accuracy run.
+                chain.reset();
+                parallelChain.reset();
+
+                const auto numSamples = (int) sampleRate;
+                juce::AudioBuffer<float> cascadeOutput(1, numSamples);
+                fillWithNoise(cascadeOutput);
+                juce::AudioBuffer<float> parallelOutput(cascadeOutput);
+
+                processFused(chain, cascadeOutput.getWritePointer(0), numSamples);
+                parallelChain.process(parallelOutput.getWritePointer(0), numSamples);
+
+                double error = 0, power = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto difference = (double) parallelOutput.getSample(0, i) - cascadeOutput.getSample(0, i);
+                    error += difference * difference;
+                    power += (double) cascadeOutput.getSample(0, i) * cascadeOutput.getSample(0, i);
+                }
+
+                results.add("parallelForm", { { "slope", getSlopeInDecibels(slope) },
+                                              { "lowCutFreq", lowCutFreq },
+                                              { "numSections", parallel.numSections },
+                                              { "valid", parallel.valid ? 1 : 0 },
+                                              { "maxError", parallel.maxError },
+                                              { "errorDecibels", 10.0 * std::log10(juce::jmax(error, 1.0e-30) / power) },
+                                              { "designNsPerCall", design.nanoseconds },
+                                              { "fusedNsPerSample", fused.nanoseconds / blockSize },
+                                              { "parallelNsPerSample", parallelTime.nanoseconds / blockSize } });
+            }
+        }
+    }
+
+    // A mix's worth of tracks, alternately mono and stereo, with the given
+    // number of distinct settings among them. Each block is run once as one
+    // chain after another on this thread, as separate instances would be,
+    // and once as a batch on the pool.
+    void runChainBatchBenchmarks(BenchmarkResults& results)
+    {
+        constexpr int numTracks = 256;
+        constexpr int blockSize = 512;
+        constexpr int iterations = 64;
+        const auto sampleRate = 48000.0;
+
+        for (auto numDistinct : { 1, 16, 256 })
+        {
+            std::vector<ChainInstance> instances(numTracks), separate(numTracks);
+            std::vector<std::vector<MonoChain*>> separatePointers(numTracks);
+            std::vector<ChainJob> jobs(numTracks);
+            std::vector<juce::AudioBuffer<float>> buffers;
+            int numChannelsInMix = 0;
+
+            for (int track = 0; track < numTracks; ++track)
+            {
+                const auto numChannels = 1 + track % 2;
+                const auto variant = track % numDistinct;
+
+                auto settings = makeSettings(allSlopes[variant % 4]);
+                settings.lowCutFreq += (float) (variant / 4);
+                settings.peakGaininDecibels = (float) (variant % 7) - 3.f;
+
+                instances[(size_t) track].prepare(numChannels);
+                separate[(size_t) track].prepare(numChannels);
+
+                const auto coefficients = makeChainCoefficients(settings, sampleRate);
+
+                for (auto& chain : separate[(size_t) track].chains)
+                {
+                    applyChainCoefficients(chain, coefficients);
+                    separatePointers[(size_t) track].push_back(&chain);
+                }
+
+                buffers.emplace_back(numChannels, blockSize);
+                fillWithNoise(buffers.back());
+                numChannelsInMix += numChannels;
+
+                jobs[(size_t) track] = { &instances[(size_t) track], settings, sampleRate, nullptr, numChannels, blockSize };
+            }
+
+            for (int track = 0; track < numTracks; ++track)
+                jobs[(size_t) track].channels = buffers[(size_t) track].getArrayOfWritePointers();
+
+            auto separateTime = measure(iterations, [&]
+            {
+                for (int track = 0; track < numTracks; ++track)
+                    processFusedChannels(separatePointers[(size_t) track].data(), buffers[(size_t) track].getArrayOfWritePointers(),
+                                         (int) separatePointers[(size_t) track].size(), blockSize);
+            });
+
+            ChainBatch batch;
+            std::vector<ChainJobTiming> timings((size_t) numTracks);
+            ChainBatchStats stats;
+
+            auto batchTime = measure(iterations, [&] { stats = batch.process(jobs.data(), numTracks, timings.data()); });
+
+            auto slowestJob = 0.0;
+
+            for (const auto& timing : timings)
+                slowestJob = juce::jmax(slowestJob, timing.processSeconds);
+
+            const auto samplesPerBlock = (double) numChannelsInMix * blockSize;
+
+            results.add("chainBatch", { { "numTracks", numTracks },
+                                        { "numDistinctSettings", numDistinct },
+                                        { "numThreads", batch.getNumThreads() },
+                                        { "numDesigns", stats.numDesigns },
+                                        { "numTasks", stats.numTasks },
+                                        { "separateNsPerSample", separateTime.nanoseconds / samplesPerBlock },
+                                        { "batchNsPerSample", batchTime.nanoseconds / samplesPerBlock },
+                                        { "batchProcessNsPerSample", stats.processSeconds * 1.0e9 / samplesPerBlock },
+                                        { "slowestJobMicroseconds", slowestJob * 1.0e6 } });
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    using Section = void (*)(BenchmarkResults&);
+    const std::pair<const char*, Section> sections[] = {
+        { "design", runDesignBenchmarks },
+        { "fastDesign", runFastDesignBenchmarks },
+        { "processBlock", runProcessBlockBenchmarks },
+        { "stereoKernel", runStereoKernelBenchmarks },
+        { "timeParallel", runTimeParallelBenchmarks },
+        { "parallelForm", runParallelFormBenchmarks },
+        { "chainBatch", runChainBatchBenchmarks },
+        { "oversampling", runOversamplingBenchmarks },
+        { "svf", runSvfBenchmarks },
+        { "linearPhase", runLinearPhaseBenchmarks },
+        { "bandGraph", runBandGraphBenchmarks },
+        { "sessionLoad", runSessionLoadBenchmarks },
+        { "parameterRead", runParameterReadBenchmarks },
+        { "analyser", runAnalyserBenchmarks },
+    };
+
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << "Usage: Benchmarks [--only=<section>] [--json=<file>]\n\nSections:";
+
+        for (auto& section : sections)
+            std::cout << " " << section.first;
+
+        std::cout << std::endl;
+        return 0;
+    }
+
+    const auto only = args.getValueForOption("--only");
+    BenchmarkResults results;
+
+    for (auto& section : sections)
+        if (only.isEmpty() || only == section.first)
+            section.second(results);
+
+    if (args.containsOption("--json"))
+    {
+        const juce::File jsonFile(args.getValueForOption("--json"));
+
+        if (! jsonFile.replaceWithText(results.toJSON()))
+        {
+            std::cerr << "Couldn't write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    // With the sanitizer built in, any section can catch the audio thread
+    // blocking; fail the run so it doesn't go unnoticed.
+    if (RealtimeSanitizer::getNumViolations() > 0)
+    {
+        std::cerr << RealtimeSanitizer::getNumViolations() << " realtime violations" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    Biquad.cpp
+
+  ==============================================================================
+*/
+
+#include "Biquad.h"
+
+namespace
+{
+    BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+    {
+        const auto a0inv = 1.0 / a0;
+        return { (float) (b0 * a0inv), (float) (b1 * a0inv), (float) (b2 * a0inv),
+                 (float) (a1 * a0inv), (float) (a2 * a0inv) };
+    }
+
+    // 1/Q of every section of an even order Butterworth filter, for each
+    // number of sections. It only depends on the order, so it's worked out
+    // once here rather than on every design.
+    struct ButterworthTable
+    {
+        ButterworthTable()
+        {
+            for (int numStages = 1; numStages <= maxButterworthStages; ++numStages)
+                for (int i = 0; i < numStages; ++i)
+                    inverseQ[numStages - 1][i] = 2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (numStages * 4.0));
+        }
+
+        double inverseQ[maxButterworthStages][maxButterworthStages]{};
+    };
+
+    const ButterworthTable butterworthTable;
+
+    // n is tan(w/2) for a high pass and its reciprocal for a low pass.
+    BiquadCoefficients makeLowPassSection(double n, double invQ) noexcept
+    {
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { (float) c1, (float) (c1 * 2.0), (float) c1,
+                 (float) (c1 * 2.0 * (1.0 - nSquared)), (float) (c1 * (1.0 - invQ * n + nSquared)) };
+    }
+
+    BiquadCoefficients makeHighPassSection(double n, double invQ) noexcept
+    {
+        const auto nSquared = n * n;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        return { (float) c1, (float) (c1 * -2.0), (float) c1,
+                 (float) (c1 * 2.0 * (nSquared - 1.0)), (float) (c1 * (1.0 - invQ * n + nSquared)) };
+    }
+
+    // All sections share one prewarped frequency, so a whole cut costs a
+    // single tan() however steep it is.
+    template <typename SectionDesign>
+    void designButterworth(CutCoefficients& result, int order, double n, SectionDesign&& makeSection) noexcept
+    {
+        jassert(order > 0 && order % 2 == 0 && order <= 2 * maxCutStages);
+
+        result.numStages = juce::jlimit(1, maxCutStages, order / 2);
+        const auto* inverseQ = butterworthTable.inverseQ[result.numStages - 1];
+
+        for (int i = 0; i < maxCutStages; ++i)
+            result.stages[(size_t) i] = i < result.numStages ? makeSection(n, inverseQ[i]) : BiquadCoefficients{};
+    }
+}
+
+// The formulas below follow juce::dsp::IIR::Coefficients so that switching
+// away from it doesn't change the sound.
+
+BiquadCoefficients makePeakCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept
+{
+    jassert(sampleRate > 0 && quality > 0);
+
+    const auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+    const auto omega = juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0) / sampleRate;
+    const auto alpha = std::sin(omega) / (quality * 2.0);
+    const auto c2 = -2.0 * std::cos(omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+BiquadCoefficients makeLowPassCoefficients(double sampleRate, double frequency, double quality) noexcept
+{
+    jassert(sampleRate > 0 && frequency > 0 && frequency <= sampleRate * 0.5);
+
+    return makeLowPassSection(1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate), 1.0 / quality);
+}
+
+BiquadCoefficients makeHighPassCoefficients(double sampleRate, double frequency, double quality) noexcept
+{
+    jassert(sampleRate > 0 && frequency > 0 && frequency <= sampleRate * 0.5);
+
+    return makeHighPassSection(std::tan(juce::MathConstants<double>::pi * frequency / sampleRate), 1.0 / quality);
+}
+
+BiquadCoefficients makeLowShelfCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept
+{
+    jassert(sampleRate > 0 && quality > 0);
+
+    const auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+    const auto aminus1 = A - 1.0, aplus1 = A + 1.0;
+    const auto omega = juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0) / sampleRate;
+    const auto coso = std::cos(omega);
+    const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+    const auto aminus1TimesCoso = aminus1 * coso;
+
+    return normalise(A * (aplus1 - aminus1TimesCoso + beta), A * 2.0 * (aminus1 - aplus1 * coso), A * (aplus1 - aminus1TimesCoso - beta),
+                     aplus1 + aminus1TimesCoso + beta, -2.0 * (aminus1 + aplus1 * coso), aplus1 + aminus1TimesCoso - beta);
+}
+
+BiquadCoefficients makeHighShelfCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept
+{
+    jassert(sampleRate > 0 && quality > 0);
+
+    const auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+    const auto aminus1 = A - 1.0, aplus1 = A + 1.0;
+    const auto omega = juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0) / sampleRate;
+    const auto coso = std::cos(omega);
+    const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+    const auto aminus1TimesCoso = aminus1 * coso;
+
+    return normalise(A * (aplus1 + aminus1TimesCoso + beta), A * -2.0 * (aminus1 + aplus1 * coso), A * (aplus1 + aminus1TimesCoso - beta),
+                     aplus1 - aminus1TimesCoso + beta, 2.0 * (aminus1 - aplus1 * coso), aplus1 - aminus1TimesCoso - beta);
+}
+
+void designButterworthHighpass(CutCoefficients& result, double frequency, double sampleRate, int order) noexcept
+{
+    jassert(sampleRate > 0 && frequency > 0 && frequency <= sampleRate * 0.5);
+
+    designButterworth(result, order, std::tan(juce::MathConstants<double>::pi * frequency / sampleRate), makeHighPassSection);
+}
+
+void designButterworthLowpass(CutCoefficients& result, double frequency, double sampleRate, int order) noexcept
+{
+    jassert(sampleRate > 0 && frequency > 0 && frequency <= sampleRate * 0.5);
+
+    designButterworth(result, order, 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate), makeLowPassSection);
+}
+
+void designButterworthSections(BiquadCoefficients* sections, int numStages, double frequency, double sampleRate, bool isHighpass) noexcept
+{
+    jassert(sampleRate > 0 && frequency > 0 && frequency <= sampleRate * 0.5);
+    jassert(numStages > 0 && numStages <= maxButterworthStages);
+
+    const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto* inverseQ = butterworthTable.inverseQ[numStages - 1];
+
+    for (int i = 0; i < numStages; ++i)
+        sections[i] = isHighpass ? makeHighPassSection(n, inverseQ[i]) : makeLowPassSection(1.0 / n, inverseQ[i]);
+}
+
+double getButterworthInverseQ(int numStages, int index) noexcept
+{
+    jassert(numStages > 0 && numStages <= maxButterworthStages && index >= 0 && index < numStages);
+
+    return butterworthTable.inverseQ[numStages - 1][index];
+}
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    Biquad.h
+
+    Plain-data second order sections and a filter that processes them, used
+    in place of juce::dsp::IIR so that updating a chain never touches the heap.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Coefficients of one second order section, normalised so that a0 == 1. */
+struct BiquadCoefficients
+{
+    float b0{ 1 }, b1{ 0 }, b2{ 0 }, a1{ 0 }, a2{ 0 };
+};
+
+/** The highest number of sections a cut filter can use (48 dB/oct). */
+constexpr int maxCutStages = 4;
+/** The steepest Butterworth cut that can be designed at all (96 dB/oct),
+    for engines that store their sections themselves.
+*/
+constexpr int maxButterworthStages = 8;
+
+/** All sections of one Butterworth cut, stored in place. Stages past
+    numStages are left as pass-through.
+*/
+struct alignas(64) CutCoefficients
+{
+    std::array<BiquadCoefficients, maxCutStages> stages;
+    int numStages{ 0 };
+
+    const BiquadCoefficients& operator[](int index) const noexcept { return stages[(size_t) index]; }
+};
+
+static_assert(std::is_trivially_copyable<BiquadCoefficients>::value
+              && std::is_trivially_copyable<CutCoefficients>::value,
+              "Coefficient storage must stay plain data so it can be copied on the audio thread");
+
+BiquadCoefficients makePeakCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept;
+BiquadCoefficients makeLowPassCoefficients(double sampleRate, double frequency, double quality) noexcept;
+BiquadCoefficients makeHighPassCoefficients(double sampleRate, double frequency, double quality) noexcept;
+BiquadCoefficients makeLowShelfCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept;
+BiquadCoefficients makeHighShelfCoefficients(double sampleRate, double frequency, double quality, double gainFactor) noexcept;
+
+/** Same designs as juce::dsp::FilterDesign's high order Butterworth methods,
+    written into existing storage instead of a freshly allocated array.
+    The order must be even and no greater than 2 * maxCutStages.
+*/
+void designButterworthHighpass(CutCoefficients& result, double frequency, double sampleRate, int order) noexcept;
+void designButterworthLowpass(CutCoefficients& result, double frequency, double sampleRate, int order) noexcept;
+
+/** Writes the numStages sections of a Butterworth cut, up to
+    maxButterworthStages, to sections.
+*/
+void designButterworthSections(BiquadCoefficients* sections, int numStages, double frequency, double sampleRate, bool isHighpass) noexcept;
+
+/** 1/Q of section index of a Butterworth cut made of numStages sections. */
+double getButterworthInverseQ(int numStages, int index) noexcept;
+
+//==============================================================================
+/**
+    A mono transposed direct form II biquad that can sit in a
+    juce::dsp::ProcessorChain. The coefficients and state live inline.
+*/
+class Biquad
+{
+public:
+    BiquadCoefficients coefficients;
+
+    void prepare(const juce::dsp::ProcessSpec&) noexcept { reset(); }
+    void reset() noexcept { s1 = s2 = 0; }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+
+        jassert(inputBlock.getNumChannels() == 1);
+        jassert(outputBlock.getNumChannels() == 1);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto* src = inputBlock.getChannelPointer(0);
+        auto* dst = outputBlock.getChannelPointer(0);
+        const auto numSamples = (int) outputBlock.getNumSamples();
+
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = processSample(src[i]);
+
+        snapToZero();
+    }
+
+    float processSample(float input) noexcept
+    {
+        const auto& c = coefficients;
+        const auto output = c.b0 * input + s1;
+        s1 = c.b1 * input - c.a1 * output + s2;
+        s2 = c.b2 * input - c.a2 * output;
+        return output;
+    }
+
+    void snapToZero() noexcept
+    {
+        juce::dsp::util::snapToZero(s1);
+        juce::dsp::util::snapToZero(s2);
+    }
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept
+    {
+        const auto& c = coefficients;
+        const auto z = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        const auto numerator = (double) c.b0 + z * ((double) c.b1 + z * (double) c.b2);
+        const auto denominator = 1.0 + z * ((double) c.a1 + z * (double) c.a2);
+        return std::abs(numerator / denominator);
+    }
+
+    float s1{ 0 }, s2{ 0 };
+};
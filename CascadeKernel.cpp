@@ -0,0 +1,304 @@
+/*
+  ==============================================================================
+
+    CascadeKernel.cpp
+
+  ==============================================================================
+*/
+
+#include "CascadeKernel.h"
+
+namespace
+{
+    Biquad& getStage(CutFilter& cut, int index) noexcept
+    {
+        switch (index)
+        {
+        case 0: return cut.get<0>();
+        case 1: return cut.get<1>();
+        case 2: return cut.get<2>();
+        default: return cut.get<3>();
+        }
+    }
+
+    template <int NumLow, bool UsePeak, int NumHigh>
+    void processCascade(MonoChain& chain, float* samples, int numSamples) noexcept
+    {
+        constexpr int numSections = NumLow + (UsePeak ? 1 : 0) + NumHigh;
+
+        if constexpr (numSections > 0)
+        {
+            std::array<Biquad*, numSections> sections;
+            int n = 0;
+
+            for (int i = 0; i < NumLow; ++i)
+                sections[(size_t) n++] = &getStage(chain.get<ChainPositions::Lowcut>(), i);
+
+            if constexpr (UsePeak)
+                sections[(size_t) n++] = &chain.get<ChainPositions::Peak>();
+
+            for (int i = 0; i < NumHigh; ++i)
+                sections[(size_t) n++] = &getStage(chain.get<ChainPositions::HighCut>(), i);
+
+            // Local copies let the compiler unroll the section loop and keep
+            // everything in registers for the whole block.
+            BiquadCoefficients c[numSections];
+            float s1[numSections], s2[numSections];
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                c[k] = sections[(size_t) k]->coefficients;
+                s1[k] = sections[(size_t) k]->s1;
+                s2[k] = sections[(size_t) k]->s2;
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (int k = 0; k < numSections; ++k)
+                {
+                    const auto y = c[k].b0 * x + s1[k];
+                    s1[k] = c[k].b1 * x - c[k].a1 * y + s2[k];
+                    s2[k] = c[k].b2 * x - c[k].a2 * y;
+                    x = y;
+                }
+
+                samples[i] = x;
+            }
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                sections[(size_t) k]->s1 = s1[k];
+                sections[(size_t) k]->s2 = s2[k];
+                sections[(size_t) k]->snapToZero();
+            }
+        }
+        else
+        {
+            juce::ignoreUnused(chain, samples, numSamples);
+        }
+    }
+
+    struct ActiveSections
+    {
+        int numLow, numHigh;
+        bool usePeak;
+    };
+
+    ActiveSections getActiveSections(const MonoChain& chain) noexcept
+    {
+        return { chain.isBypassed<ChainPositions::Lowcut>() ? 0 : getNumActiveStages(chain.get<ChainPositions::Lowcut>()),
+                 chain.isBypassed<ChainPositions::HighCut>() ? 0 : getNumActiveStages(chain.get<ChainPositions::HighCut>()),
+                 ! chain.isBypassed<ChainPositions::Peak>() };
+    }
+
+   #if JUCE_USE_SIMD
+    using LaneVector = juce::dsp::SIMDRegister<float>;
+    constexpr int numLanes = (int) LaneVector::SIMDNumElements;
+
+    template <int NumLow, bool UsePeak, int NumHigh>
+    void processCascadeLanes(MonoChain* const* chains, float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        constexpr int numSections = NumLow + (UsePeak ? 1 : 0) + NumHigh;
+
+        if constexpr (numSections > 0)
+        {
+            // Sections a lane doesn't use stay null and run as pass-through
+            // with zero state, which leaves that lane's signal untouched.
+            Biquad* sections[numSections][numLanes] = {};
+
+            for (int lane = 0; lane < numChannels; ++lane)
+            {
+                auto& chain = *chains[lane];
+                const auto active = getActiveSections(chain);
+                int n = 0;
+
+                for (int i = 0; i < NumLow; ++i, ++n)
+                    if (i < active.numLow)
+                        sections[n][lane] = &getStage(chain.get<ChainPositions::Lowcut>(), i);
+
+                if constexpr (UsePeak)
+                {
+                    if (active.usePeak)
+                        sections[n][lane] = &chain.get<ChainPositions::Peak>();
+
+                    ++n;
+                }
+
+                for (int i = 0; i < NumHigh; ++i, ++n)
+                    if (i < active.numHigh)
+                        sections[n][lane] = &getStage(chain.get<ChainPositions::HighCut>(), i);
+            }
+
+            LaneVector b0[numSections], b1[numSections], b2[numSections], a1[numSections], a2[numSections];
+            LaneVector s1[numSections], s2[numSections];
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                alignas(LaneVector::SIMDRegisterSize) float values[7][numLanes];
+
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    const auto* section = sections[k][lane];
+                    const auto c = section != nullptr ? section->coefficients : BiquadCoefficients{};
+
+                    values[0][lane] = c.b0;
+                    values[1][lane] = c.b1;
+                    values[2][lane] = c.b2;
+                    values[3][lane] = c.a1;
+                    values[4][lane] = c.a2;
+                    values[5][lane] = section != nullptr ? section->s1 : 0.0f;
+                    values[6][lane] = section != nullptr ? section->s2 : 0.0f;
+                }
+
+                b0[k] = LaneVector::fromRawArray(values[0]);
+                b1[k] = LaneVector::fromRawArray(values[1]);
+                b2[k] = LaneVector::fromRawArray(values[2]);
+                a1[k] = LaneVector::fromRawArray(values[3]);
+                a2[k] = LaneVector::fromRawArray(values[4]);
+                s1[k] = LaneVector::fromRawArray(values[5]);
+                s2[k] = LaneVector::fromRawArray(values[6]);
+            }
+
+            alignas(LaneVector::SIMDRegisterSize) float frame[numLanes] = {};
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int lane = 0; lane < numChannels; ++lane)
+                    frame[lane] = channels[lane][i];
+
+                auto x = LaneVector::fromRawArray(frame);
+
+                for (int k = 0; k < numSections; ++k)
+                {
+                    const auto y = b0[k] * x + s1[k];
+                    s1[k] = b1[k] * x - a1[k] * y + s2[k];
+                    s2[k] = b2[k] * x - a2[k] * y;
+                    x = y;
+                }
+
+                x.copyToRawArray(frame);
+
+                for (int lane = 0; lane < numChannels; ++lane)
+                    channels[lane][i] = frame[lane];
+            }
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                alignas(LaneVector::SIMDRegisterSize) float state1[numLanes], state2[numLanes];
+                s1[k].copyToRawArray(state1);
+                s2[k].copyToRawArray(state2);
+
+                for (int lane = 0; lane < numChannels; ++lane)
+                {
+                    if (auto* section = sections[k][lane])
+                    {
+                        section->s1 = state1[lane];
+                        section->s2 = state2[lane];
+                        section->snapToZero();
+                    }
+                }
+            }
+        }
+        else
+        {
+            juce::ignoreUnused(chains, channels, numChannels, numSamples);
+        }
+    }
+   #endif
+
+    using CascadeFunction = void (*)(MonoChain&, float*, int) noexcept;
+    using LaneCascadeFunction = void (*)(MonoChain* const*, float* const*, int, int) noexcept;
+
+    constexpr int numStageCounts = maxCutStages + 1;
+
+    constexpr size_t getCascadeIndex(int numLow, bool usePeak, int numHigh) noexcept
+    {
+        return (size_t) ((numLow * 2 + (usePeak ? 1 : 0)) * numStageCounts + numHigh);
+    }
+
+    // Both tables are indexed by getCascadeIndex().
+    template <size_t... Index>
+    constexpr std::array<CascadeFunction, sizeof...(Index)> makeCascadeTable(std::index_sequence<Index...>) noexcept
+    {
+        return { { &processCascade<(int) (Index / (2 * numStageCounts)),
+                                   (Index / numStageCounts) % 2 == 1,
+                                   (int) (Index % numStageCounts)>... } };
+    }
+
+    constexpr auto cascadeTable = makeCascadeTable(std::make_index_sequence<numStageCounts * 2 * numStageCounts>());
+
+   #if JUCE_USE_SIMD
+    template <size_t... Index>
+    constexpr std::array<LaneCascadeFunction, sizeof...(Index)> makeLaneCascadeTable(std::index_sequence<Index...>) noexcept
+    {
+        return { { &processCascadeLanes<(int) (Index / (2 * numStageCounts)),
+                                        (Index / numStageCounts) % 2 == 1,
+                                        (int) (Index % numStageCounts)>... } };
+    }
+
+    constexpr auto laneCascadeTable = makeLaneCascadeTable(std::make_index_sequence<numStageCounts * 2 * numStageCounts>());
+   #endif
+}
+
+int getNumActiveStages(const CutFilter& cut) noexcept
+{
+    if (cut.isBypassed<0>()) return 0;
+    if (cut.isBypassed<1>()) return 1;
+    if (cut.isBypassed<2>()) return 2;
+    if (cut.isBypassed<3>()) return 3;
+    return 4;
+}
+
+void processFused(MonoChain& chain, float* samples, int numSamples) noexcept
+{
+    const auto active = getActiveSections(chain);
+    cascadeTable[getCascadeIndex(active.numLow, active.usePeak, active.numHigh)](chain, samples, numSamples);
+}
+
+void processFusedLanes(MonoChain* const* chains, float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert(numChannels > 0 && numChannels <= getNumFusedLanes());
+
+   #if JUCE_USE_SIMD
+    ActiveSections widest{ 0, 0, false };
+
+    for (int lane = 0; lane < numChannels; ++lane)
+    {
+        const auto active = getActiveSections(*chains[lane]);
+        widest.numLow = juce::jmax(widest.numLow, active.numLow);
+        widest.numHigh = juce::jmax(widest.numHigh, active.numHigh);
+        widest.usePeak = widest.usePeak || active.usePeak;
+    }
+
+    laneCascadeTable[getCascadeIndex(widest.numLow, widest.usePeak, widest.numHigh)](chains, channels, numChannels, numSamples);
+   #else
+    for (int channel = 0; channel < numChannels; ++channel)
+        processFused(*chains[channel], channels[channel], numSamples);
+   #endif
+}
+
+void processFusedChannels(MonoChain* const* chains, float* const* channels, int numChannels, int numSamples) noexcept
+{
+    const auto numLanes = getNumFusedLanes();
+
+    for (int first = 0; first < numChannels; first += numLanes)
+    {
+        const auto numInGroup = juce::jmin(numLanes, numChannels - first);
+
+        if (numInGroup == 1)
+            processFused(*chains[first], channels[first], numSamples);
+        else
+            processFusedLanes(chains + first, channels + first, numInGroup, numSamples);
+    }
+}
+
+int getNumFusedLanes() noexcept
+{
+   #if JUCE_USE_SIMD
+    return numLanes;
+   #else
+    return 1;
+   #endif
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    CascadeKernel.h
+
+    Single pass processing of a whole MonoChain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+/** Processes one channel through every active section of the chain (low cut
+    stages, peak, high cut stages) in a single loop, keeping the section
+    state in registers instead of making one pass over the block per filter.
+
+    Produces the same result as chain.process() on the same data. The chain's
+    bypass flags choose one of the kernels specialised on the number of active
+    stages, so bypassed stages cost nothing.
+*/
+void processFused(MonoChain& chain, float* samples, int numSamples) noexcept;
+
+/** Processes numChannels channels side by side, one per SIMD lane, each
+    through its own chain, so every section runs once for all of them.
+
+    The chains may hold different coefficients and slopes; a lane with fewer
+    active stages than the others just passes through the extra ones.
+    numChannels must not exceed getNumFusedLanes().
+*/
+void processFusedLanes(MonoChain* const* chains, float* const* channels, int numChannels, int numSamples) noexcept;
+
+/** Processes any number of channels, each through its own chain, in groups
+    as wide as a SIMD register so each section runs once per group.
+*/
+void processFusedChannels(MonoChain* const* chains, float* const* channels, int numChannels, int numSamples) noexcept;
+
+/** How many channels processFusedLanes() can handle at once. This is 1 when
+    JUCE was built without SIMD support.
+*/
+int getNumFusedLanes() noexcept;
+
+/** The number of leading stages of a cut filter that are not bypassed. */
+int getNumActiveStages(const CutFilter& cut) noexcept;
@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    ChainBatch.cpp
+
+  ==============================================================================
+*/
+
+#include "ChainBatch.h"
+#include "CascadeKernel.h"
+#include <numeric>
+
+namespace
+{
+    auto getDesignKey(const ChainSettings& s, double sampleRate) noexcept
+    {
+        return std::make_tuple(sampleRate, s.lowCutFreq, s.highCutFreq, s.peakFreq, s.peakGaininDecibels, s.peakQuality,
+                               (int) s.lowCutSlope, (int) s.highCutSlope);
+    }
+
+    auto getDesignKey(const ChainJob& job) noexcept
+    {
+        return getDesignKey(job.settings, job.sampleRate);
+    }
+
+    /** Which bands are active and how steep the cuts are. Chains with the same
+        shape run exactly the same sections, so none of a SIMD register's
+        lanes idle while the others work.
+    */
+    int getShape(const ChainSettings& settings) noexcept
+    {
+        auto shape = getActiveBands(settings);
+
+        if (isBandActive(settings, ChainPositions::Lowcut))
+            shape |= (settings.lowCutSlope + 1) << 4;
+
+        if (isBandActive(settings, ChainPositions::HighCut))
+            shape |= (settings.highCutSlope + 1) << 8;
+
+        return shape;
+    }
+
+    double getSecondsSince(juce::int64 startTicks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+}
+
+void ChainInstance::prepare(int numChannels)
+{
+    chains.resize((size_t) numChannels);
+
+    for (auto& chain : chains)
+        chain.reset();
+
+    // Nothing has been applied at this rate, so the next design will be.
+    appliedSampleRate = 0;
+}
+
+//==============================================================================
+ChainBatch::ChainBatch(int numThreads)
+    : pool(numThreads)
+{
+}
+
+ChainBatchStats ChainBatch::process(const ChainJob* jobs, int numJobs, ChainJobTiming* timings)
+{
+    ChainBatchStats stats;
+    stats.numJobs = numJobs;
+
+    if (numJobs <= 0)
+        return stats;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Jobs with the same design end up next to each other.
+    jobOrder.resize((size_t) numJobs);
+    std::iota(jobOrder.begin(), jobOrder.end(), 0);
+    std::sort(jobOrder.begin(), jobOrder.end(), [jobs](int a, int b) { return getDesignKey(jobs[a]) < getDesignKey(jobs[b]); });
+
+    designs.clear();
+
+    for (int i = 0; i < numJobs; ++i)
+    {
+        if (i == 0 || getDesignKey(jobs[jobOrder[(size_t) i]]) != getDesignKey(jobs[jobOrder[(size_t) i - 1]]))
+            designs.push_back({ i, 0, 0.0 });
+
+        ++designs.back().numJobs;
+    }
+
+    // Each design goes only to its own jobs, and no two jobs share an
+    // instance, so the workers never touch the same chains.
+    pool.run((int) designs.size(), [&](int designIndex, int)
+    {
+        const auto designStart = juce::Time::getHighResolutionTicks();
+        auto& design = designs[(size_t) designIndex];
+        const auto& first = jobs[jobOrder[(size_t) design.firstJob]];
+        const auto key = getDesignKey(first);
+
+        // Only designed if some instance doesn't have it already, as it won't
+        // from one block to the next while the settings stay put.
+        std::optional<ChainCoefficients> coefficients;
+
+        for (int i = design.firstJob; i < design.firstJob + design.numJobs; ++i)
+        {
+            const auto& job = jobs[jobOrder[(size_t) i]];
+            jassert(job.instance != nullptr && (int) job.instance->chains.size() >= job.numChannels);
+            auto& instance = *job.instance;
+
+            if (getDesignKey(instance.appliedSettings, instance.appliedSampleRate) == key)
+                continue;
+
+            if (! coefficients.has_value())
+                coefficients = makeChainCoefficients(first.settings, first.sampleRate);
+
+            for (auto& chain : instance.chains)
+                applyChainCoefficients(chain, *coefficients);
+
+            instance.appliedSettings = job.settings;
+            instance.appliedSampleRate = job.sampleRate;
+        }
+
+        design.seconds = getSecondsSince(designStart);
+    });
+
+    // Every channel becomes a lane; sorting them puts channels that run the
+    // same sections next to each other, so processFusedChannels() fills its
+    // SIMD groups with them.
+    lanes.clear();
+
+    for (int job = 0; job < numJobs; ++job)
+    {
+        if (jobs[job].numSamples <= 0)
+            continue;
+
+        const auto shape = getShape(jobs[job].settings);
+
+        for (int channel = 0; channel < jobs[job].numChannels; ++channel)
+            lanes.push_back({ jobs[job].numSamples, shape, job, channel });
+    }
+
+    std::sort(lanes.begin(), lanes.end(), [](const Lane& a, const Lane& b)
+    {
+        return std::tie(a.numSamples, a.shape, a.job, a.channel) < std::tie(b.numSamples, b.shape, b.job, b.channel);
+    });
+
+    const auto numLanes = (int) lanes.size();
+    laneChains.resize((size_t) numLanes);
+    laneChannels.resize((size_t) numLanes);
+    laneSeconds.assign((size_t) numLanes, 0.0);
+    tasks.clear();
+
+    for (int i = 0; i < numLanes; ++i)
+    {
+        const auto& lane = lanes[(size_t) i];
+        laneChains[(size_t) i] = &jobs[lane.job].instance->chains[(size_t) lane.channel];
+        laneChannels[(size_t) i] = jobs[lane.job].channels[lane.channel];
+
+        // A task only covers one block size, since its channels run together.
+        if (tasks.empty() || tasks.back().numLanes == maxChannelsPerTask
+            || lanes[(size_t) tasks.back().firstLane].numSamples != lane.numSamples)
+            tasks.push_back({ i, 0 });
+
+        ++tasks.back().numLanes;
+    }
+
+    pool.run((int) tasks.size(), [&](int taskIndex, int)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        const auto taskStart = juce::Time::getHighResolutionTicks();
+        const auto& task = tasks[(size_t) taskIndex];
+
+        processFusedChannels(laneChains.data() + task.firstLane, laneChannels.data() + task.firstLane,
+                             task.numLanes, lanes[(size_t) task.firstLane].numSamples);
+
+        const auto seconds = getSecondsSince(taskStart) / task.numLanes;
+
+        for (int i = task.firstLane; i < task.firstLane + task.numLanes; ++i)
+            laneSeconds[(size_t) i] = seconds;
+    });
+
+    stats.wallSeconds = getSecondsSince(startTicks);
+    stats.numDesigns = (int) designs.size();
+    stats.numTasks = (int) tasks.size();
+
+    for (const auto& design : designs)
+        stats.designSeconds += design.seconds;
+
+    stats.processSeconds = std::accumulate(laneSeconds.begin(), laneSeconds.end(), 0.0);
+
+    if (timings != nullptr)
+    {
+        std::fill(timings, timings + numJobs, ChainJobTiming());
+
+        for (size_t d = 0; d < designs.size(); ++d)
+        {
+            for (int i = designs[d].firstJob; i < designs[d].firstJob + designs[d].numJobs; ++i)
+            {
+                auto& timing = timings[jobOrder[(size_t) i]];
+                timing.designIndex = (int) d;
+                timing.numSharingDesign = designs[d].numJobs;
+                timing.designSeconds = designs[d].seconds;
+            }
+        }
+
+        for (int i = 0; i < numLanes; ++i)
+            timings[lanes[(size_t) i].job].processSeconds += laneSeconds[(size_t) i];
+    }
+
+    return stats;
+}
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    ChainBatch.h
+
+    Runs many independent EQs (e.g. one per track of a mix) through their
+    filter chains at once, on a shared work-stealing pool, without an
+    AudioProcessor per EQ.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterChain.h"
+#include "WorkStealingPool.h"
+
+/** One EQ's chains, one per channel. The caller keeps it from one batch to
+    the next so the filter state carries over between blocks.
+*/
+struct ChainInstance
+{
+    std::vector<MonoChain> chains;
+
+    /** Clears the state and sizes it for numChannels. */
+    void prepare(int numChannels);
+
+private:
+    friend class ChainBatch;
+
+    // The design last applied, so an unchanged one isn't applied again.
+    ChainSettings appliedSettings;
+    double appliedSampleRate{ 0 };
+};
+
+/** One EQ's block: its settings, and its audio, which is processed in place.
+    No two jobs in a batch may share an instance.
+*/
+struct ChainJob
+{
+    ChainInstance* instance{ nullptr };
+    ChainSettings settings;
+    double sampleRate{ 44100.0 };
+    float* const* channels{ nullptr };
+    int numChannels{ 0 }, numSamples{ 0 };
+};
+
+struct ChainJobTiming
+{
+    /** Jobs with the same settings and sample rate share one design. This is
+        its index in the batch, how many jobs shared it, and how long it took.
+    */
+    int designIndex{ -1 }, numSharingDesign{ 0 };
+    double designSeconds{ 0 };
+    /** This job's share of the time spent in the kernels its channels ran in,
+        split evenly between the channels in each.
+    */
+    double processSeconds{ 0 };
+};
+
+struct ChainBatchStats
+{
+    /** Distinct designs, whether or not any needed making, and the tasks the
+        channels were split into.
+    */
+    int numJobs{ 0 }, numDesigns{ 0 }, numTasks{ 0 };
+    /** Totals over every worker, and the time the whole batch took. */
+    double designSeconds{ 0 }, processSeconds{ 0 }, wallSeconds{ 0 };
+};
+
+/**
+    Processes a batch of jobs in two passes over the pool. First each
+    distinct design is made once, and applied to the chains of every job
+    that uses it. Then the jobs' channels are sorted by the shape of their
+    chains (which bands are active, how steep the cuts are) and block size,
+    and run side by side through processFusedChannels() in tasks of up to
+    maxChannelsPerTask, so tracks with the same layout but different
+    settings still fill the SIMD lanes together.
+
+    A chain whose settings change between batches jumps straight to the new
+    design; there's no smoothing, as with the offline renderer.
+*/
+class ChainBatch
+{
+public:
+    /** Zero or less means one thread per hardware thread. */
+    explicit ChainBatch(int numThreads = 0);
+
+    /** Runs every job and waits for them all. If timings isn't null it gets
+        one entry per job.
+    */
+    ChainBatchStats process(const ChainJob* jobs, int numJobs, ChainJobTiming* timings = nullptr);
+
+    int getNumThreads() const noexcept { return pool.getNumWorkers(); }
+
+    static constexpr int maxChannelsPerTask = 16;
+
+private:
+    struct Design
+    {
+        int firstJob, numJobs;
+        double seconds;
+    };
+
+    struct Lane
+    {
+        int numSamples, shape, job, channel;
+    };
+
+    struct Task
+    {
+        int firstLane, numLanes;
+    };
+
+    WorkStealingPool pool;
+
+    // Scratch space, kept between batches so they don't allocate once sized.
+    std::vector<int> jobOrder;
+    std::vector<Design> designs;
+    std::vector<Lane> lanes;
+    std::vector<Task> tasks;
+    std::vector<MonoChain*> laneChains;
+    std::vector<float*> laneChannels;
+    std::vector<double> laneSeconds;
+
+    JUCE_DECLARE_NON_COPYABLE(ChainBatch)
+};
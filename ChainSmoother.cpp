@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    ChainSmoother.cpp
+
+  ==============================================================================
+*/
+
+#include "ChainSmoother.h"
+#include "DesignMath.h"
+
+void ChainSmoother::prepare(double newSampleRate, double newRampLengthSeconds) noexcept
+{
+    sampleRate = newSampleRate;
+    rampLengthSeconds = newRampLengthSeconds;
+
+    for (auto* value : { &lowCutFreq, &highCutFreq, &peakFreq, &peakQuality })
+        value->reset(sampleRate, rampLengthSeconds);
+
+    peakGain.reset(sampleRate, rampLengthSeconds);
+    smoothing = false;
+}
+
+void ChainSmoother::reset(const ChainCoefficients& coefficients) noexcept
+{
+    const auto& settings = coefficients.settings;
+
+    lowCutFreq.setCurrentAndTargetValue(settings.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(settings.highCutFreq);
+    peakFreq.setCurrentAndTargetValue(settings.peakFreq);
+    peakQuality.setCurrentAndTargetValue(settings.peakQuality);
+    peakGain.setCurrentAndTargetValue(settings.peakGaininDecibels);
+
+    current = target = coefficients;
+    smoothing = false;
+}
+
+void ChainSmoother::setTarget(const ChainCoefficients& coefficients) noexcept
+{
+    // A new sample rate means new coefficients anyway, so there's nothing to
+    // glide from.
+    if (current.sampleRate != coefficients.sampleRate || sampleRate <= 0)
+    {
+        reset(coefficients);
+        return;
+    }
+
+    const auto& settings = coefficients.settings;
+
+    lowCutFreq.setTargetValue(settings.lowCutFreq);
+    highCutFreq.setTargetValue(settings.highCutFreq);
+    peakFreq.setTargetValue(settings.peakFreq);
+    peakQuality.setTargetValue(settings.peakQuality);
+    peakGain.setTargetValue(settings.peakGaininDecibels);
+
+    target = coefficients;
+
+    if (current.settings.lowCutSlope != settings.lowCutSlope)
+    {
+        current.settings.lowCutSlope = settings.lowCutSlope;
+        current.lowCut = makeLowCutFilter(current.settings, sampleRate);
+    }
+
+    if (current.settings.highCutSlope != settings.highCutSlope)
+    {
+        current.settings.highCutSlope = settings.highCutSlope;
+        current.highCut = makeHighCutFilter(current.settings, sampleRate);
+    }
+
+    smoothing = lowCutFreq.isSmoothing() || highCutFreq.isSmoothing() || peakFreq.isSmoothing()
+             || peakQuality.isSmoothing() || peakGain.isSmoothing();
+
+    if (! smoothing)
+        current = target;
+}
+
+void ChainSmoother::advance(int numSamples) noexcept
+{
+    if (! smoothing)
+        return;
+
+    auto& settings = current.settings;
+    const auto lowCutMoving = lowCutFreq.isSmoothing();
+    const auto highCutMoving = highCutFreq.isSmoothing();
+    const auto peakMoving = peakFreq.isSmoothing() || peakQuality.isSmoothing() || peakGain.isSmoothing();
+
+    settings.lowCutFreq = lowCutFreq.skip(numSamples);
+    settings.highCutFreq = highCutFreq.skip(numSamples);
+    settings.peakFreq = peakFreq.skip(numSamples);
+    settings.peakQuality = peakQuality.skip(numSamples);
+    settings.peakGaininDecibels = peakGain.skip(numSamples);
+
+    smoothing = lowCutFreq.isSmoothing() || highCutFreq.isSmoothing() || peakFreq.isSmoothing()
+             || peakQuality.isSmoothing() || peakGain.isSmoothing();
+
+    // Once the ramp has arrived, use the published coefficients themselves so
+    // the result is exactly what an unsmoothed change would have produced.
+    if (! smoothing)
+    {
+        current = target;
+        return;
+    }
+
+    // Only the bands that are actually moving need redesigning. The points
+    // in between are only heard for a few samples each, so they come from
+    // the polynomial designers, which are close enough and much cheaper.
+    if (lowCutMoving)
+        current.lowCut = makeLowCutFilterFast(settings, sampleRate);
+
+    if (highCutMoving)
+        current.highCut = makeHighCutFilterFast(settings, sampleRate);
+
+    if (peakMoving)
+        current.peak = makePeakFilterFast(settings, sampleRate);
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    ChainSmoother.h
+
+    Glides a chain's coefficients towards newly published ones in small steps.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+/**
+    Rather than jumping to new coefficients once per host block, the settings
+    are ramped in a domain where every intermediate point is a valid, stable
+    filter: frequencies and Q multiplicatively, gain linearly in decibels.
+    The coefficients are redesigned from the ramped settings every few samples
+    using the polynomial designers in DesignMath.h, which call no trig at all;
+    the end of the ramp lands on the published coefficients.
+
+    Slopes can't be interpolated, so a slope change takes effect immediately.
+    Everything here is safe to call on the audio thread.
+*/
+class ChainSmoother
+{
+public:
+    ChainSmoother() = default;
+
+    void prepare(double sampleRate, double rampLengthSeconds) noexcept;
+
+    /** Jumps straight to the given coefficients. */
+    void reset(const ChainCoefficients& coefficients) noexcept;
+
+    /** Starts a ramp from wherever we are now towards the given coefficients. */
+    void setTarget(const ChainCoefficients& coefficients) noexcept;
+
+    bool isSmoothing() const noexcept { return smoothing; }
+
+    /** Moves the ramp on by numSamples and redesigns the current coefficients. */
+    void advance(int numSamples) noexcept;
+
+    const ChainCoefficients& getCurrent() const noexcept { return current; }
+
+private:
+    using LogSmoothedValue = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    double sampleRate{ 0 }, rampLengthSeconds{ 0.05 };
+    LogSmoothedValue lowCutFreq, highCutFreq, peakFreq, peakQuality;
+    juce::SmoothedValue<float> peakGain;
+
+    ChainCoefficients current, target;
+    bool smoothing{ false };
+};
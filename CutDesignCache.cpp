@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    CutDesignCache.cpp
+
+  ==============================================================================
+*/
+
+#include "CutDesignCache.h"
+
+CutDesignCache& CutDesignCache::getInstance()
+{
+    static CutDesignCache instance;
+    return instance;
+}
+
+juce::uint64 CutDesignCache::makeKey(Type type, double frequency, double sampleRate, int order) noexcept
+{
+    // frequency (whole Hz, < 2^20) | sample rate (whole Hz, < 2^24) | order | type | valid
+    return ((juce::uint64) frequency & 0xfffff)
+         | (((juce::uint64) juce::roundToInt(sampleRate) & 0xffffff) << 20)
+         | (((juce::uint64) order & 0xff) << 44)
+         | ((juce::uint64) (type == Type::lowpass ? 1 : 0) << 52)
+         | ((juce::uint64) 1 << 53);
+}
+
+void CutDesignCache::design(Type type, double frequency, double sampleRate, int order, CutCoefficients& result) noexcept
+{
+    auto designDirectly = [&]
+    {
+        if (type == Type::highpass)
+            designButterworthHighpass(result, frequency, sampleRate, order);
+        else
+            designButterworthLowpass(result, frequency, sampleRate, order);
+    };
+
+    if (frequency != std::floor(frequency) || frequency >= (1 << 20) || sampleRate != std::floor(sampleRate))
+    {
+        designDirectly();
+        return;
+    }
+
+    const auto key = makeKey(type, frequency, sampleRate, order);
+
+    // A 64-bit finaliser spreads neighbouring frequencies over the table.
+    auto hash = key;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    auto& entry = entries[(size_t) (hash & (numEntries - 1))];
+
+    if (read(entry, key, result))
+    {
+        numHits.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    numMisses.fetch_add(1, std::memory_order_relaxed);
+    designDirectly();
+    write(entry, key, result);
+}
+
+bool CutDesignCache::read(const Entry& entry, juce::uint64 key, CutCoefficients& result) const noexcept
+{
+    const auto sequence = entry.sequence.load(std::memory_order_acquire);
+
+    if ((sequence & 1) != 0 || entry.key.load(std::memory_order_relaxed) != key)
+        return false;
+
+    result.numStages = entry.numStages.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < maxCutStages; ++i)
+    {
+        const auto* v = entry.values.data() + i * 5;
+        result.stages[(size_t) i] = { v[0].load(std::memory_order_relaxed), v[1].load(std::memory_order_relaxed),
+                                      v[2].load(std::memory_order_relaxed), v[3].load(std::memory_order_relaxed),
+                                      v[4].load(std::memory_order_relaxed) };
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return entry.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+void CutDesignCache::write(Entry& entry, juce::uint64 key, const CutCoefficients& coefficients) noexcept
+{
+    // If another thread is filling this entry, let it win rather than wait.
+    if (entry.writing.test_and_set(std::memory_order_acquire))
+        return;
+
+    const auto sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.key.store(key, std::memory_order_relaxed);
+    entry.numStages.store(coefficients.numStages, std::memory_order_relaxed);
+
+    for (int i = 0; i < maxCutStages; ++i)
+    {
+        const auto& c = coefficients[i];
+        auto* v = entry.values.data() + i * 5;
+        v[0].store(c.b0, std::memory_order_relaxed);
+        v[1].store(c.b1, std::memory_order_relaxed);
+        v[2].store(c.b2, std::memory_order_relaxed);
+        v[3].store(c.a1, std::memory_order_relaxed);
+        v[4].store(c.a2, std::memory_order_relaxed);
+    }
+
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+    entry.writing.clear(std::memory_order_release);
+}
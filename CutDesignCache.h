@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    CutDesignCache.h
+
+    A process-wide table of recently designed Butterworth cut filters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "Biquad.h"
+
+/**
+    The cut frequency parameters move in 1 Hz steps and there are only a few
+    slopes, so sessions with many instances keep asking for the same designs.
+    This remembers them in a fixed-size, direct-mapped table shared by every
+    instance in the process.
+
+    Lookups never block or allocate, so they're safe on the audio thread: each
+    entry is guarded by a sequence counter, and a reader that races with a
+    writer just treats it as a miss. Only whole-Hz frequencies are cached;
+    anything else (e.g. a smoothed glide) is designed directly so it doesn't
+    push useful entries out.
+*/
+class CutDesignCache
+{
+public:
+    enum class Type
+    {
+        highpass,
+        lowpass
+    };
+
+    /** The shared instance. */
+    static CutDesignCache& getInstance();
+
+    /** Fills result from the cache, designing and remembering it on a miss. */
+    void design(Type type, double frequency, double sampleRate, int order, CutCoefficients& result) noexcept;
+
+    juce::uint64 getNumHits() const noexcept { return numHits.load(std::memory_order_relaxed); }
+    juce::uint64 getNumMisses() const noexcept { return numMisses.load(std::memory_order_relaxed); }
+
+    static constexpr int numEntries = 2048;
+
+private:
+    CutDesignCache() = default;
+
+    struct Entry
+    {
+        std::atomic<juce::uint32> sequence{ 0 };
+        std::atomic_flag writing = ATOMIC_FLAG_INIT;
+        std::atomic<juce::uint64> key{ 0 };
+        std::atomic<int> numStages{ 0 };
+        std::array<std::atomic<float>, maxCutStages * 5> values{};
+    };
+
+    std::array<Entry, numEntries> entries;
+    std::atomic<juce::uint64> numHits{ 0 }, numMisses{ 0 };
+
+    static juce::uint64 makeKey(Type type, double frequency, double sampleRate, int order) noexcept;
+    bool read(const Entry& entry, juce::uint64 key, CutCoefficients& result) const noexcept;
+    void write(Entry& entry, juce::uint64 key, const CutCoefficients& coefficients) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(CutDesignCache)
+};
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    DesignMath.cpp
+
+  ==============================================================================
+*/
+
+#include "DesignMath.h"
+
+namespace
+{
+    // 1/Q of every cut stage, as in Biquad.cpp, but in float and worked out
+    // here so it doesn't depend on another file's static initialisation.
+    struct InverseQTable
+    {
+        InverseQTable()
+        {
+            for (int numStages = 1; numStages <= maxCutStages; ++numStages)
+                for (int i = 0; i < numStages; ++i)
+                    values[numStages - 1][i] = (float) (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (numStages * 4.0)));
+        }
+
+        float values[maxCutStages][maxCutStages]{};
+    };
+
+    const InverseQTable inverseQTable;
+
+    // Keeps t = pi * ratio short of pi/2, where the tangent is infinite.
+    constexpr float maxCutRatio = 0.4999f;
+
+    /** The sections are worked out one lane at a time by these, so that the
+        loops calling them over a batch are straight-line arithmetic.
+    */
+    struct Section
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    // Every coefficient near +-1 or +-2 is worked out as that value plus a
+    // small correction, which keeps its own relative accuracy; so the rounding
+    // to float at the end is most of the error, as it is in the reference's
+    // double precision designs. Where the poles are near z = 1 (t < pi/4) the
+    // correction to a1 is taken from -2, and otherwise from +2.
+
+    forcedinline Section designPeak(float frequencyRatio, float quality, float gainDecibels) noexcept
+    {
+        float s, c;
+        DesignMath::getPrewarpSinCos(frequencyRatio, s, c);
+
+        // sin(omega) for omega = 2t, and 1 - cos(omega), 1 + cos(omega).
+        const auto sinOmega = 2.f * s * c;
+        const auto A = DesignMath::decibelsToSqrtGain(gainDecibels);
+        const auto alpha = sinOmega / (2.f * quality);
+        const auto k = alpha / A;
+        const auto a0inv = 1.f / (1.f + k);
+        const auto a1 = s < c ? -2.f + 2.f * (2.f * s * s + k) * a0inv
+                              : 2.f - 2.f * (2.f * c * c + k) * a0inv;
+
+        return { 1.f + alpha * (A - 1.f / A) * a0inv, a1, 1.f - alpha * (A + 1.f / A) * a0inv, a1, 1.f - 2.f * k * a0inv };
+    }
+
+    // n is tan(t) for a high pass and its reciprocal for a low pass, as in
+    // Biquad.cpp. A low pass's a1 is the high pass's negated.
+    template <bool IsHighpass>
+    forcedinline Section designCutStage(float n, float inverseQ) noexcept
+    {
+        const auto c1 = 1.f / (1.f + inverseQ * n + n * n);
+        const auto highpassA1 = n < 1.f ? -2.f + 2.f * c1 * n * (2.f * n + inverseQ)
+                                        : 2.f - 2.f * c1 * (2.f + inverseQ * n);
+
+        return { c1, IsHighpass ? -2.f * c1 : 2.f * c1, c1, IsHighpass ? highpassA1 : -highpassA1, 1.f - 2.f * inverseQ * n * c1 };
+    }
+
+    template <bool IsHighpass>
+    forcedinline float getCutN(float frequencyRatio) noexcept
+    {
+        float s, c;
+        DesignMath::getPrewarpSinCos(juce::jmin(frequencyRatio, maxCutRatio), s, c);
+        return IsHighpass ? s / c : c / s;
+    }
+
+    inline int getNumStages(Slope slope) noexcept
+    {
+        return juce::jlimit(1, maxCutStages, (int) slope + 1);
+    }
+
+    //==============================================================================
+    using Lanes = float[designBatchSize];
+
+    struct SectionLanes
+    {
+        alignas(32) Lanes b0, b1, b2, a1, a2;
+
+        void set(int lane, const Section& s) noexcept
+        {
+            b0[lane] = s.b0; b1[lane] = s.b1; b2[lane] = s.b2; a1[lane] = s.a1; a2[lane] = s.a2;
+        }
+
+        BiquadCoefficients get(int lane) const noexcept
+        {
+            return { b0[lane], b1[lane], b2[lane], a1[lane], a2[lane] };
+        }
+    };
+
+    template <bool IsHighpass>
+    void designCutLanes(const Lanes frequencyRatio, const int* numStages, CutCoefficients* const* results, int numLanes) noexcept
+    {
+        alignas(32) Lanes n, inverseQ;
+
+        for (int lane = 0; lane < designBatchSize; ++lane)
+            n[lane] = getCutN<IsHighpass>(frequencyRatio[lane]);
+
+        for (int stage = 0; stage < maxCutStages; ++stage)
+        {
+            SectionLanes sections;
+
+            for (int lane = 0; lane < designBatchSize; ++lane)
+                inverseQ[lane] = inverseQTable.values[numStages[lane] - 1][stage];
+
+            for (int lane = 0; lane < designBatchSize; ++lane)
+                sections.set(lane, designCutStage<IsHighpass>(n[lane], inverseQ[lane]));
+
+            // Stages past the slope are left as pass-through.
+            for (int lane = 0; lane < numLanes; ++lane)
+                results[lane]->stages[(size_t) stage] = stage < numStages[lane] ? sections.get(lane) : BiquadCoefficients{};
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            results[lane]->numStages = numStages[lane];
+    }
+
+    template <bool IsHighpass>
+    CutCoefficients makeCutFast(float frequency, Slope slope, double sampleRate) noexcept
+    {
+        CutCoefficients result;
+        result.numStages = getNumStages(slope);
+
+        const auto n = getCutN<IsHighpass>(frequency * (float) (1.0 / sampleRate));
+
+        for (int stage = 0; stage < result.numStages; ++stage)
+        {
+            const auto s = designCutStage<IsHighpass>(n, inverseQTable.values[result.numStages - 1][stage]);
+            result.stages[(size_t) stage] = { s.b0, s.b1, s.b2, s.a1, s.a2 };
+        }
+
+        return result;
+    }
+}
+
+void makeChainCoefficientsBatch(const ChainSettings* settings, double sampleRate, ChainCoefficients* results, int count) noexcept
+{
+    jassert(sampleRate > 0);
+
+    const auto inverseSampleRate = (float) (1.0 / sampleRate);
+
+    for (int first = 0; first < count; first += designBatchSize)
+    {
+        const auto numLanes = juce::jmin(designBatchSize, count - first);
+
+        alignas(32) Lanes lowCutRatio, highCutRatio, peakRatio, peakQuality, peakGain;
+        int lowCutStages[designBatchSize], highCutStages[designBatchSize];
+        CutCoefficients* lowCuts[designBatchSize];
+        CutCoefficients* highCuts[designBatchSize];
+
+        // A short batch repeats its last chain in the spare lanes, so every
+        // loop below can run the full width.
+        for (int lane = 0; lane < designBatchSize; ++lane)
+        {
+            const auto index = first + juce::jmin(lane, numLanes - 1);
+            const auto& s = settings[index];
+
+            lowCutRatio[lane] = s.lowCutFreq * inverseSampleRate;
+            highCutRatio[lane] = s.highCutFreq * inverseSampleRate;
+            peakRatio[lane] = juce::jmax(s.peakFreq, 2.f) * inverseSampleRate;
+            peakQuality[lane] = s.peakQuality;
+            peakGain[lane] = s.peakGaininDecibels;
+            lowCutStages[lane] = getNumStages(s.lowCutSlope);
+            highCutStages[lane] = getNumStages(s.highCutSlope);
+            lowCuts[lane] = &results[index].lowCut;
+            highCuts[lane] = &results[index].highCut;
+        }
+
+        SectionLanes peaks;
+
+        for (int lane = 0; lane < designBatchSize; ++lane)
+            peaks.set(lane, designPeak(peakRatio[lane], peakQuality[lane], peakGain[lane]));
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto& result = results[first + lane];
+            result.settings = settings[first + lane];
+            result.sampleRate = sampleRate;
+            result.peak = peaks.get(lane);
+        }
+
+        designCutLanes<true>(lowCutRatio, lowCutStages, lowCuts, numLanes);
+        designCutLanes<false>(highCutRatio, highCutStages, highCuts, numLanes);
+    }
+}
+
+BiquadCoefficients makePeakFilterFast(const ChainSettings& settings, double sampleRate) noexcept
+{
+    const auto s = designPeak(juce::jmax(settings.peakFreq, 2.f) * (float) (1.0 / sampleRate), settings.peakQuality, settings.peakGaininDecibels);
+    return { s.b0, s.b1, s.b2, s.a1, s.a2 };
+}
+
+CutCoefficients makeLowCutFilterFast(const ChainSettings& settings, double sampleRate) noexcept
+{
+    return makeCutFast<true>(settings.lowCutFreq, settings.lowCutSlope, sampleRate);
+}
+
+CutCoefficients makeHighCutFilterFast(const ChainSettings& settings, double sampleRate) noexcept
+{
+    return makeCutFast<false>(settings.highCutFreq, settings.highCutSlope, sampleRate);
+}
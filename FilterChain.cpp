@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    FilterChain.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterChain.h"
+
+Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makePeakCoefficients(sampleRate, 
+        chainSettings.peakFreq, chainSettings.peakQuality, 
+        juce::Decibels::decibelsToGain(chainSettings.peakGaininDecibels));
+
+}
+
+ void updateCoefficients(Coefficients& old, const Coefficients& replacements) {
+     old = replacements;
+
+}
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients coefficients;
+    coefficients.settings = chainSettings;
+    coefficients.sampleRate = sampleRate;
+    coefficients.peak = makePeakFilter(chainSettings, sampleRate);
+    coefficients.lowCut = makeLowCutFilter(chainSettings, sampleRate);
+    coefficients.highCut = makeHighCutFilter(chainSettings, sampleRate);
+
+    return coefficients;
+}
+
+namespace
+{
+    template <int Band>
+    void setBandActive(MonoChain& chain, bool shouldBeActive)
+    {
+        // Whatever state was left from the last time it ran is stale.
+        if (shouldBeActive && chain.isBypassed<Band>())
+            chain.get<Band>().reset();
+
+        chain.setBypassed<Band>(! shouldBeActive);
+    }
+}
+
+void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& coefficients)
+{
+    const auto& settings = coefficients.settings;
+
+    updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, coefficients.peak);
+    updateCutFilter(chain.get<ChainPositions::Lowcut>(), coefficients.lowCut, settings.lowCutSlope);
+    updateCutFilter(chain.get<ChainPositions::HighCut>(), coefficients.highCut, settings.highCutSlope);
+
+    setBandActive<ChainPositions::Lowcut>(chain, isBandActive(settings, ChainPositions::Lowcut));
+    setBandActive<ChainPositions::Peak>(chain, isBandActive(settings, ChainPositions::Peak));
+    setBandActive<ChainPositions::HighCut>(chain, isBandActive(settings, ChainPositions::HighCut));
+}
+
+bool isCutAudible(float frequency, int order, bool isLowCut) noexcept
+{
+    // The analogue response at the nearer edge of the band is
+    // 1 / (1 + x^(2 order)) in power, x being the edge's distance past the
+    // cutoff; bilinear warping only makes the cut fall away faster.
+    const auto x = isLowCut ? (double) frequency / minCutFrequency
+                            : (double) maxCutFrequency / juce::jmax(frequency, 1.f);
+    const auto threshold = std::pow(10.0, neutralDecibels / 10.0) - 1.0;
+
+    return 2.0 * order * std::log(juce::jmax(x, 1.0e-9)) > std::log(threshold);
+}
+
+bool isBandActive(const ChainSettings& settings, ChainPositions band) noexcept
+{
+    switch (band)
+    {
+    case ChainPositions::Lowcut:
+        return isCutAudible(settings.lowCutFreq, 2 * (settings.lowCutSlope + 1), true);
+
+    case ChainPositions::Peak:
+        // Well under the parameter's 0.5 dB step.
+        return std::abs(settings.peakGaininDecibels) > neutralDecibels;
+
+    case ChainPositions::HighCut:
+        return isCutAudible(settings.highCutFreq, 2 * (settings.highCutSlope + 1), false);
+    }
+
+    return true;
+}
+
+int getActiveBands(const ChainSettings& settings) noexcept
+{
+    int bands = 0;
+
+    for (auto band : { ChainPositions::Lowcut, ChainPositions::Peak, ChainPositions::HighCut })
+        if (isBandActive(settings, band))
+            bands |= 1 << band;
+
+    return bands;
+}
+
+int getActiveBands(const MonoChain& chain) noexcept
+{
+    return (chain.isBypassed<ChainPositions::Lowcut>() ? 0 : 1 << ChainPositions::Lowcut)
+         | (chain.isBypassed<ChainPositions::Peak>() ? 0 : 1 << ChainPositions::Peak)
+         | (chain.isBypassed<ChainPositions::HighCut>() ? 0 : 1 << ChainPositions::HighCut);
+}
+
+int getActiveSections(const ChainCoefficients& coefficients, BiquadCoefficients* sections) noexcept
+{
+    const auto& settings = coefficients.settings;
+    int numSections = 0;
+
+    if (isBandActive(settings, ChainPositions::Lowcut))
+        for (int i = 0; i < juce::jmin((int) settings.lowCutSlope + 1, coefficients.lowCut.numStages); ++i)
+            sections[numSections++] = coefficients.lowCut[i];
+
+    if (isBandActive(settings, ChainPositions::Peak))
+        sections[numSections++] = coefficients.peak;
+
+    if (isBandActive(settings, ChainPositions::HighCut))
+        for (int i = 0; i < juce::jmin((int) settings.highCutSlope + 1, coefficients.highCut.numStages); ++i)
+            sections[numSections++] = coefficients.highCut[i];
+
+    return numSections;
+}
+
+int getDecayLengthInSamples(const BiquadCoefficients* sections, int numSections, double sampleRate, double decibels)
+{
+    const auto logLevel = std::log(juce::Decibels::decibelsToGain(decibels, -300.0));
+    const auto maxLength = 60.0 * sampleRate;
+
+    auto getSectionLength = [&](const BiquadCoefficients& c)
+    {
+        // The slowest pole dominates; for a complex pair both have radius sqrt(a2).
+        const auto a1 = (double) c.a1, a2 = (double) c.a2;
+        const auto discriminant = a1 * a1 - 4.0 * a2;
+        auto radius = std::sqrt(std::abs(a2));
+
+        if (discriminant >= 0)
+            radius = juce::jmax(std::abs(-a1 + std::sqrt(discriminant)), std::abs(-a1 - std::sqrt(discriminant))) * 0.5;
+
+        if (radius <= 0)
+            return 2.0;
+
+        if (radius >= 1.0)
+            return maxLength;
+
+        return logLevel / std::log(radius) + 2.0;
+    };
+
+    // Summing the sections over-estimates the cascade's decay, which is the
+    // safe direction for everything that uses it.
+    auto length = 0.0;
+
+    for (int i = 0; i < numSections; ++i)
+        length += getSectionLength(sections[i]);
+
+    return (int) std::ceil(juce::jmin(length, maxLength));
+}
+
+int getDecayLengthInSamples(const ChainCoefficients& coefficients, double decibels)
+{
+    std::array<BiquadCoefficients, maxChainSections> sections;
+    const auto numSections = getActiveSections(coefficients, sections.data());
+
+    return getDecayLengthInSamples(sections.data(), numSections, coefficients.sampleRate, decibels);
+}
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    FilterChain.h
+
+    The EQ's filter chain and its coefficient design, independent of the
+    plugin wrapper so it can also be used by offline tools.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Biquad.h"
+#include "CutDesignCache.h"
+
+enum Slope {
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+
+class ChainSettings {
+public:
+    float peakFreq{ 0 }, peakGaininDecibels{ 0 }, peakQuality{ 1.f };
+    float lowCutFreq{ 0 }, highCutFreq{ 0 };
+
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+
+};
+
+using Filter = Biquad;
+using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+enum ChainPositions {
+    Lowcut,
+    Peak,
+    HighCut
+};
+using Coefficients = BiquadCoefficients;
+
+ void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+
+ Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+
+ template<int Index, typename ChainType, typename CoefficientType>
+ void update(ChainType& chain, const CoefficientType& coefficients)
+ {
+     updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
+     chain.template setBypassed<Index>(false);
+ }
+
+ template<typename ChainType, typename CoefficientType>
+ void updateCutFilter(ChainType& chain, const CoefficientType& coefficients,
+     const Slope& slope) {
+     chain.template setBypassed<0>(true);
+     chain.template setBypassed<1>(true);
+     chain.template setBypassed<2>(true);
+     chain.template setBypassed<3>(true);
+
+     switch (slope)
+     {
+     case Slope_48:
+     {
+         update<3>(chain, coefficients);
+     }
+     case Slope_36:
+     {
+         update<2>(chain, coefficients);
+     }
+     case Slope_24:
+     {
+         update<1>(chain, coefficients);
+     }
+     case Slope_12:
+     {
+         update<0>(chain, coefficients);
+     }
+     }
+ }
+
+ inline CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+ {
+     CutCoefficients coefficients;
+     CutDesignCache::getInstance().design(CutDesignCache::Type::highpass, chainSettings.lowCutFreq, sampleRate
+         , 2 * (chainSettings.lowCutSlope + 1), coefficients);
+     return coefficients;
+
+ }
+ inline CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+ {
+     CutCoefficients coefficients;
+     CutDesignCache::getInstance().design(CutDesignCache::Type::lowpass, chainSettings.highCutFreq, sampleRate,
+         2 * (chainSettings.highCutSlope + 1), coefficients);
+     return coefficients;
+ }
+
+ /** Everything needed to configure a MonoChain for one set of parameters.
+     Built off the audio thread and handed over through a SnapshotExchange;
+     it's plain data, so applying it never allocates.
+ */
+ struct ChainCoefficients
+ {
+     ChainSettings settings;
+     double sampleRate{ 0 };
+     Coefficients peak;
+     CutCoefficients lowCut, highCut;
+ };
+
+ static_assert(std::is_trivially_copyable<ChainCoefficients>::value, "");
+
+ /** The most sections a MonoChain can have active: both cuts at 48 dB/oct
+     and the peak.
+ */
+ constexpr int maxChainSections = 2 * maxCutStages + 1;
+
+ ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+ /** Applies the coefficients and bypasses any band that isBandActive() says
+     is neutral. A band coming back out of bypass starts from a clear state.
+ */
+ void applyChainCoefficients(MonoChain& chain, const ChainCoefficients& coefficients);
+
+ /** The ends of the audible band, which is also the cut frequency range. */
+ constexpr float minCutFrequency = 20.f, maxCutFrequency = 20000.f;
+
+ /** How little a band may change the level by and still count as neutral. */
+ constexpr float neutralDecibels = 0.01f;
+
+ /** True if a Butterworth cut of the given order takes more than
+     neutralDecibels off anywhere in the audible band. A cut at 20 Hz or
+     20 kHz is still 3 dB down there, so only one well outside the band
+     (which the parameters can't reach) counts as neutral.
+ */
+ bool isCutAudible(float frequency, int order, bool isLowCut) noexcept;
+
+ /** False for a band that leaves the signal effectively untouched: a cut
+     that isn't isCutAudible(), or a peak with no gain. Those are skipped
+     rather than processed.
+ */
+ bool isBandActive(const ChainSettings& settings, ChainPositions band) noexcept;
+
+ /** Bit (1 << band) set for each band that isBandActive(), or for a chain,
+     each band that isn't bypassed.
+ */
+ int getActiveBands(const ChainSettings& settings) noexcept;
+ int getActiveBands(const MonoChain& chain) noexcept;
+
+ /** Copies the sections applyChainCoefficients() would leave active to
+     sections, in processing order, and returns how many there are.
+ */
+ int getActiveSections(const ChainCoefficients& coefficients, BiquadCoefficients* sections) noexcept;
+
+ /** A conservative estimate of how long the chain's impulse response takes
+     to fall below the given level (e.g. -120 dB), worked out from the pole
+     radius of every active section. Lower cut frequencies, steeper slopes and
+     narrower peaks all ring for longer.
+ */
+ int getDecayLengthInSamples(const ChainCoefficients& coefficients, double decibels);
+ /** The same estimate for any cascade of sections. */
+ int getDecayLengthInSamples(const BiquadCoefficients* sections, int numSections, double sampleRate, double decibels);
@@ -0,0 +1,397 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseConvolver.h"
+
+namespace
+{
+    constexpr int slotMask = 7;
+
+    int getPending(int state) noexcept  { return state & slotMask; }
+    int getCurrent(int state) noexcept  { return (state >> 3) & slotMask; }
+    int getPrevious(int state) noexcept { return (state >> 6) & slotMask; }
+
+    int makeState(int pending, int current, int previous) noexcept
+    {
+        return pending | (current << 3) | (previous << 6);
+    }
+
+    // The upper half of a real signal's spectrum mirrors the lower half, which
+    // is all that's kept; some FFT implementations want it filled in anyway.
+    void fillNegativeFrequencies(float* data, int fftSize) noexcept
+    {
+        for (int k = fftSize / 2 + 1; k < fftSize; ++k)
+        {
+            data[2 * k] = data[2 * (fftSize - k)];
+            data[2 * k + 1] = -data[2 * (fftSize - k) + 1];
+        }
+    }
+}
+
+LinearPhaseConvolver::LinearPhaseConvolver()
+    : juce::Thread("Linear Phase Kernels")
+{
+    slotState.store(makeState(noSlot, noSlot, noSlot));
+}
+
+LinearPhaseConvolver::~LinearPhaseConvolver()
+{
+    release();
+}
+
+void LinearPhaseConvolver::prepare(double newSampleRate, int numChannels)
+{
+    jassert(newSampleRate > 0);
+
+    release();
+
+    sampleRate = newSampleRate;
+    kernelLength = juce::nextPowerOfTwo(juce::roundToInt(sampleRate * kernelSeconds));
+    partitionSize = kernelLength / numPartitions;
+    spectrumSize = 2 * (partitionSize + 1);
+
+    const auto partitionOrder = juce::roundToInt(std::log2(2 * partitionSize));
+    partitionFft = std::make_unique<juce::dsp::FFT>(partitionOrder);
+    designPartitionFft = std::make_unique<juce::dsp::FFT>(partitionOrder);
+    designFft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(kernelLength)));
+
+    for (auto& slot : kernelSlots)
+        slot.assign((size_t) (maxKernels * numPartitions * spectrumSize), 0.0f);
+
+    slotState.store(makeState(noSlot, noSlot, noSlot));
+
+    channelStates.resize((size_t) juce::jmax(0, numChannels));
+
+    for (auto& state : channelStates)
+    {
+        state.input.assign((size_t) (2 * partitionSize), 0.0f);
+        state.output.assign((size_t) partitionSize, 0.0f);
+        state.spectra.assign((size_t) (numPartitions * spectrumSize), 0.0f);
+        state.newestSpectrum = 0;
+    }
+
+    transformBuffer.assign((size_t) (4 * partitionSize), 0.0f);
+    accumulator.assign((size_t) spectrumSize, 0.0f);
+    fadeBuffer.assign((size_t) partitionSize, 0.0f);
+    position = 0;
+
+    designBuffer.assign((size_t) (2 * kernelLength), 0.0f);
+    designTransform.assign((size_t) (4 * partitionSize), 0.0f);
+
+    // A periodic Blackman window, centred on the kernel's peak at
+    // kernelLength / 2, so the response dies away smoothly at both ends.
+    window.resize((size_t) kernelLength);
+
+    for (int n = 0; n < kernelLength; ++n)
+    {
+        const auto phase = juce::MathConstants<double>::twoPi * n / kernelLength;
+        window[(size_t) n] = (float) (0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase));
+    }
+
+    std::vector<float> binFrequencies((size_t) (kernelLength / 2 + 1));
+
+    for (size_t k = 0; k < binFrequencies.size(); ++k)
+        binFrequencies[k] = (float) (k * sampleRate / kernelLength);
+
+    response.setFrequencies(std::move(binFrequencies));
+
+    {
+        const juce::ScopedLock sl(requestLock);
+        requestPending = false;
+    }
+
+    startThread();
+}
+
+void LinearPhaseConvolver::release()
+{
+    stopThread(4000);
+
+    // Hand back everything prepare() took, so an engine that isn't in use
+    // costs nothing but the object itself.
+    auto freeVector = [](auto& vector) { std::decay_t<decltype(vector)>().swap(vector); };
+
+    for (auto& slot : kernelSlots)
+        freeVector(slot);
+
+    slotState.store(makeState(noSlot, noSlot, noSlot));
+
+    freeVector(channelStates);
+    freeVector(transformBuffer);
+    freeVector(accumulator);
+    freeVector(fadeBuffer);
+    freeVector(designBuffer);
+    freeVector(designTransform);
+    freeVector(window);
+
+    partitionFft.reset();
+    designFft.reset();
+    designPartitionFft.reset();
+    response = ResponseCurve();
+
+    sampleRate = 0;
+    kernelLength = partitionSize = spectrumSize = 0;
+    position = 0;
+}
+
+void LinearPhaseConvolver::reset() noexcept
+{
+    for (auto& state : channelStates)
+    {
+        std::fill(state.input.begin(), state.input.end(), 0.0f);
+        std::fill(state.output.begin(), state.output.end(), 0.0f);
+        std::fill(state.spectra.begin(), state.spectra.end(), 0.0f);
+    }
+
+    position = 0;
+}
+
+//==============================================================================
+void LinearPhaseConvolver::requestKernels(const ChainCoefficients* coefficients, int numKernels, bool buildNow)
+{
+    jassert(numKernels > 0 && numKernels <= maxKernels);
+
+    if (kernelLength == 0)
+        return;
+
+    Request newRequest;
+    newRequest.numKernels = juce::jlimit(1, maxKernels, numKernels);
+    std::copy(coefficients, coefficients + newRequest.numKernels, newRequest.coefficients.begin());
+
+    if (buildNow)
+    {
+        const juce::ScopedLock sl(buildLock);
+        buildKernels(newRequest);
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl(requestLock);
+        request = newRequest;
+        requestPending = true;
+    }
+
+    notify();
+}
+
+bool LinearPhaseConvolver::hasKernels() const noexcept
+{
+    const auto state = slotState.load(std::memory_order_acquire);
+    return getPending(state) != noSlot || getCurrent(state) != noSlot;
+}
+
+void LinearPhaseConvolver::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(-1);
+
+        Request nextRequest;
+
+        {
+            const juce::ScopedLock sl(requestLock);
+
+            if (! requestPending)
+                continue;
+
+            nextRequest = request;
+            requestPending = false;
+        }
+
+        const juce::ScopedLock sl(buildLock);
+        buildKernels(nextRequest);
+    }
+}
+
+void LinearPhaseConvolver::buildKernels(const Request& kernelRequest)
+{
+    // The audio thread only ever moves slots along from pending to current to
+    // previous and then drops them, so one that's free now stays free.
+    auto state = slotState.load(std::memory_order_acquire);
+    auto slot = 0;
+
+    while (slot == getPending(state) || slot == getCurrent(state) || slot == getPrevious(state))
+        ++slot;
+
+    jassert(slot < numSlots);
+    auto* kernels = kernelSlots[(size_t) slot].data();
+
+    const auto kernelSize = numPartitions * spectrumSize;
+
+    for (int i = 0; i < kernelRequest.numKernels; ++i)
+        designKernel(kernelRequest.coefficients[(size_t) i], kernels + i * kernelSize);
+
+    // Channels pointing past the kernels asked for get the first one.
+    for (int i = kernelRequest.numKernels; i < maxKernels; ++i)
+        std::copy(kernels, kernels + kernelSize, kernels + i * kernelSize);
+
+    // Replaces any pending set the audio thread hasn't picked up yet.
+    while (! slotState.compare_exchange_weak(state, makeState(slot, getCurrent(state), getPrevious(state)),
+                                             std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+    }
+}
+
+void LinearPhaseConvolver::designKernel(const ChainCoefficients& coefficients, float* partitionSpectra)
+{
+    response.update(coefficients);
+
+    // Zero phase: the magnitude alone, as a real spectrum.
+    const auto* decibels = response.getMagnitudesInDecibels();
+    auto* buffer = designBuffer.data();
+
+    for (int k = 0; k <= kernelLength / 2; ++k)
+    {
+        buffer[2 * k] = juce::Decibels::decibelsToGain(decibels[k], -300.0f);
+        buffer[2 * k + 1] = 0.0f;
+    }
+
+    fillNegativeFrequencies(buffer, kernelLength);
+    designFft->performRealOnlyInverseTransform(buffer);
+
+    // The impulse is centred on time zero, wrapping round, so delay it by
+    // half the kernel and window it, into the spare second half of the buffer.
+    auto* kernel = buffer + kernelLength;
+    const auto half = kernelLength / 2;
+
+    for (int n = 0; n < kernelLength; ++n)
+        kernel[n] = buffer[(n + half) & (kernelLength - 1)] * window[(size_t) n];
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        auto* transform = designTransform.data();
+        std::fill(designTransform.begin(), designTransform.end(), 0.0f);
+        std::copy(kernel + p * partitionSize, kernel + (p + 1) * partitionSize, transform);
+
+        designPartitionFft->performRealOnlyForwardTransform(transform, true);
+        std::copy(transform, transform + spectrumSize, partitionSpectra + p * spectrumSize);
+    }
+}
+
+//==============================================================================
+void LinearPhaseConvolver::process(float* const* channels, const int* kernelIndices, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, (int) channelStates.size());
+
+    for (int done = 0; done < numSamples;)
+    {
+        // Collect up to the end of the partition, handing back the output
+        // worked out at the end of the last one.
+        const auto numToCopy = juce::jmin(numSamples - done, partitionSize - position);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = channelStates[(size_t) channel];
+            auto* samples = channels[channel] + done;
+
+            std::copy(samples, samples + numToCopy, state.input.data() + partitionSize + position);
+            std::copy(state.output.data() + position, state.output.data() + position + numToCopy, samples);
+        }
+
+        position += numToCopy;
+        done += numToCopy;
+
+        if (position == partitionSize)
+        {
+            processPartition(kernelIndices, numChannels);
+            position = 0;
+        }
+    }
+}
+
+void LinearPhaseConvolver::processPartition(const int* kernelIndices, int numChannels) noexcept
+{
+    // Pick up a newly built set, fading out of the one in use.
+    auto state = slotState.load(std::memory_order_acquire);
+
+    while (getPending(state) != noSlot
+           && ! slotState.compare_exchange_weak(state, makeState(noSlot, getPending(state), getCurrent(state)),
+                                                std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+    }
+
+    if (getPending(state) != noSlot)
+        state = makeState(noSlot, getPending(state), getCurrent(state));
+
+    const auto current = getCurrent(state), previous = getPrevious(state);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& channelState = channelStates[(size_t) channel];
+        const auto kernelIndex = juce::jlimit(0, maxKernels - 1, kernelIndices[channel]);
+
+        // Overlap-save: transform the last two partitions of input...
+        auto* transform = transformBuffer.data();
+        std::copy(channelState.input.begin(), channelState.input.end(), transform);
+        partitionFft->performRealOnlyForwardTransform(transform, true);
+
+        channelState.newestSpectrum = (channelState.newestSpectrum + 1) % numPartitions;
+        std::copy(transform, transform + spectrumSize, channelState.spectra.data() + channelState.newestSpectrum * spectrumSize);
+        std::copy(channelState.input.begin() + partitionSize, channelState.input.end(), channelState.input.begin());
+
+        // ...and keep the second half of each result.
+        auto* output = channelState.output.data();
+
+        if (current == noSlot)
+        {
+            std::fill(channelState.output.begin(), channelState.output.end(), 0.0f);
+            continue;
+        }
+
+        convolve(channelState, getKernel(current, kernelIndex), output);
+
+        if (previous != noSlot)
+        {
+            convolve(channelState, getKernel(previous, kernelIndex), fadeBuffer.data());
+
+            for (int i = 0; i < partitionSize; ++i)
+            {
+                const auto amount = (float) (i + 1) / (float) partitionSize;
+                output[i] = fadeBuffer[(size_t) i] + amount * (output[i] - fadeBuffer[(size_t) i]);
+            }
+        }
+    }
+
+    // Done with the old kernels, so the design thread may reuse their slot.
+    if (previous != noSlot)
+    {
+        auto expected = slotState.load(std::memory_order_acquire);
+
+        while (! slotState.compare_exchange_weak(expected, makeState(getPending(expected), getCurrent(expected), noSlot),
+                                                 std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+        }
+    }
+}
+
+void LinearPhaseConvolver::convolve(const ChannelState& state, const float* kernel, float* destination) noexcept
+{
+    auto* sum = accumulator.data();
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+    // Partition p of the kernel meets the input from p partitions ago.
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto age = (state.newestSpectrum - p + numPartitions) % numPartitions;
+        const auto* x = state.spectra.data() + age * spectrumSize;
+        const auto* h = kernel + p * spectrumSize;
+
+        for (int k = 0; k < spectrumSize; k += 2)
+        {
+            sum[k]     += x[k] * h[k]     - x[k + 1] * h[k + 1];
+            sum[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+        }
+    }
+
+    auto* transform = transformBuffer.data();
+    std::copy(sum, sum + spectrumSize, transform);
+    fillNegativeFrequencies(transform, 2 * partitionSize);
+    partitionFft->performRealOnlyInverseTransform(transform);
+
+    std::copy(transform + partitionSize, transform + 2 * partitionSize, destination);
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.h
+
+    Runs the chain's magnitude response as a linear phase FIR, using
+    uniformly partitioned overlap-save convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterChain.h"
+#include "ResponseCurve.h"
+
+/**
+    The kernels are designed from ChainCoefficients by sampling the chain's
+    magnitude at every FFT bin, giving it zero phase, and windowing the result
+    to kernelSeconds. Designing happens on a background thread (or on the
+    caller's, with buildNow), and the audio thread crossfades from the old
+    kernel to the new one over one partition, so it never allocates, locks
+    or waits.
+
+    The kernel is split into numPartitions partitions of getPartitionSize()
+    samples, each convolved in the frequency domain against a delay line of
+    input spectra. The cost per sample depends only on the sample rate, not
+    on the slopes or how many bands are active.
+
+    Up to maxKernels kernels can be used at once, e.g. one per channel group,
+    with each channel choosing its own in process().
+*/
+class LinearPhaseConvolver : private juce::Thread
+{
+public:
+    LinearPhaseConvolver();
+    ~LinearPhaseConvolver() override;
+
+    /** Allocates everything for the given rate and channel count and starts
+        the design thread. The audio thread mustn't be using it. Any kernels
+        from before are discarded.
+    */
+    void prepare(double sampleRate, int numChannels);
+    /** Stops the design thread and frees everything prepare() allocated. The
+        audio thread mustn't be using it.
+    */
+    void release();
+    bool isPrepared() const noexcept { return kernelLength > 0; }
+
+    /** Audio thread: clears the signal history but keeps the kernels. */
+    void reset() noexcept;
+
+    /** Designs kernels for the first numKernels coefficients. With buildNow
+        they're ready when this returns, which is for when the audio thread
+        isn't running or is rendering offline; otherwise this returns straight
+        away and the design thread builds them.
+        Any thread but the audio thread.
+    */
+    void requestKernels(const ChainCoefficients* coefficients, int numKernels, bool buildNow);
+
+    /** True once a set of kernels has been built since prepare(), whether or
+        not the audio thread has picked it up yet. Until then the output is
+        silent, so the first set should be built with buildNow.
+    */
+    bool hasKernels() const noexcept;
+
+    /** Audio thread: convolves each channel with kernel kernelIndices[channel],
+        in place. Until the first kernels are ready the output is silent.
+    */
+    void process(float* const* channels, const int* kernelIndices, int numChannels, int numSamples) noexcept;
+
+    /** Half the kernel, plus one partition of buffering. */
+    int getLatencyInSamples() const noexcept { return kernelLength / 2 + partitionSize; }
+    int getKernelLength() const noexcept { return kernelLength; }
+    int getPartitionSize() const noexcept { return partitionSize; }
+
+    static constexpr int maxKernels = 4;
+    static constexpr int numPartitions = 16;
+    /** Rounded up to a power of two: 8192 taps at 44.1 or 48 kHz, which
+        resolves a cut down to about 20 Hz.
+    */
+    static constexpr double kernelSeconds = 0.17;
+
+private:
+    struct Request
+    {
+        std::array<ChainCoefficients, maxKernels> coefficients;
+        int numKernels{ 0 };
+    };
+
+    // One channel's signal history. input holds the previous partition of
+    // samples followed by the one being collected, and spectra is a ring of
+    // the last numPartitions input spectra, newest at newestSpectrum.
+    struct ChannelState
+    {
+        std::vector<float> input, output, spectra;
+        int newestSpectrum{ 0 };
+    };
+
+    void run() override;
+    void buildKernels(const Request& request);
+    void designKernel(const ChainCoefficients& coefficients, float* partitionSpectra);
+
+    void processPartition(const int* kernelIndices, int numChannels) noexcept;
+    void convolve(const ChannelState& state, const float* kernel, float* destination) noexcept;
+
+    const float* getKernel(int slot, int kernelIndex) const noexcept
+    {
+        return kernelSlots[(size_t) slot].data() + (size_t) (kernelIndex * numPartitions * spectrumSize);
+    }
+
+    double sampleRate{ 0 };
+    int kernelLength{ 0 }, partitionSize{ 0 }, spectrumSize{ 0 };
+
+    // Kernel storage, each slot holding maxKernels kernels as the spectra of
+    // their partitions. The slots in use are packed into slotState, a field
+    // of three bits each, so both threads always see a consistent set:
+    // pending is built but not picked up yet, current is being convolved
+    // with, and previous is being faded out. The fourth is free to build into.
+    static constexpr int numSlots = 4, noSlot = 7;
+    std::array<std::vector<float>, numSlots> kernelSlots;
+    std::atomic<int> slotState{ 0 };
+
+    // Audio thread.
+    std::vector<ChannelState> channelStates;
+    std::unique_ptr<juce::dsp::FFT> partitionFft;
+    std::vector<float> transformBuffer, accumulator, fadeBuffer;
+    int position{ 0 };
+
+    // Design side, guarded by buildLock.
+    juce::CriticalSection buildLock;
+    std::unique_ptr<juce::dsp::FFT> designFft, designPartitionFft;
+    std::vector<float> designBuffer, designTransform, window;
+    ResponseCurve response;
+
+    // Guarded by requestLock.
+    juce::CriticalSection requestLock;
+    Request request;
+    bool requestPending{ false };
+
+    JUCE_DECLARE_NON_COPYABLE(LinearPhaseConvolver)
+};
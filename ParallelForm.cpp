@@ -0,0 +1,333 @@
+/*
+  ==============================================================================
+
+    ParallelForm.cpp
+
+  ==============================================================================
+*/
+
+#include "ParallelForm.h"
+
+namespace
+{
+    using Complex = std::complex<double>;
+
+    // Both in terms of w = z^-1.
+    Complex getNumerator(const BiquadCoefficients& c, Complex w) noexcept
+    {
+        return (double) c.b0 + w * ((double) c.b1 + w * (double) c.b2);
+    }
+
+    Complex getDenominator(const BiquadCoefficients& c, Complex w) noexcept
+    {
+        return 1.0 + w * ((double) c.a1 + w * (double) c.a2);
+    }
+
+    constexpr int numChecks = 24;
+
+    /** The largest difference between the two responses, from about 10 Hz at
+        48 kHz up to Nyquist.
+    */
+    double getMaxError(const BiquadCoefficients* sections, int numSections, const ParallelCoefficients& parallel) noexcept
+    {
+        auto maxError = 0.0;
+
+        for (int i = 0; i < numChecks; ++i)
+        {
+            const auto omega = juce::MathConstants<double>::pi * std::pow(10.0, -3.3 * (1.0 - (double) i / (numChecks - 1)));
+            const auto w = std::polar(1.0, -omega);
+
+            Complex cascade = 1.0;
+
+            for (int k = 0; k < numSections; ++k)
+                cascade *= getNumerator(sections[k], w) / getDenominator(sections[k], w);
+
+            Complex sum = (double) parallel.direct;
+
+            for (size_t k = 0; k < (size_t) parallel.numSections; ++k)
+                sum += ((double) parallel.c0[k] + w * (double) parallel.c1[k])
+                     / (1.0 + w * ((double) parallel.a1[k] + w * (double) parallel.a2[k]));
+
+            maxError = juce::jmax(maxError, std::abs(sum - cascade) / juce::jmax(1.0, std::abs(cascade)));
+        }
+
+        return maxError;
+    }
+}
+
+ParallelCoefficients makeParallelCoefficients(const ChainCoefficients& coefficients) noexcept
+{
+    std::array<BiquadCoefficients, maxChainSections> sections;
+    const auto numSections = getActiveSections(coefficients, sections.data());
+    return makeParallelCoefficients(sections.data(), numSections);
+}
+
+ParallelCoefficients makeParallelCoefficients(const BiquadCoefficients* sections, int numSections) noexcept
+{
+    jassert(numSections >= 0 && numSections <= maxChainSections);
+
+    ParallelCoefficients result;
+    result.numSections = numSections;
+
+    // Each section's two poles, from z^2 + a1 z + a2. A pole at the origin
+    // or a repeated one has no simple residue, so the expansion is left
+    // invalid.
+    std::array<Complex, 2 * maxChainSections> poles;
+    auto direct = 1.0;
+
+    for (int k = 0; k < numSections; ++k)
+    {
+        const auto a1 = (double) sections[k].a1, a2 = (double) sections[k].a2;
+
+        if (std::abs(a2) < 1.0e-12)
+            return result;
+
+        const auto root = std::sqrt(Complex(a1 * a1 - 4.0 * a2));
+        poles[(size_t) (2 * k)] = (-a1 + root) * 0.5;
+        poles[(size_t) (2 * k + 1)] = (-a1 - root) * 0.5;
+
+        if (std::abs(root) < 1.0e-9)
+            return result;
+
+        // As z^-1 grows without bound only each b2 / a2 is left.
+        direct *= (double) sections[k].b2 / a2;
+    }
+
+    // The residue at each pole p of section m is the rest of H(z^-1) there,
+    // with section m's (1 - p z^-1) factor taken out.
+    for (int m = 0; m < numSections; ++m)
+    {
+        Complex residues[2];
+
+        for (int side = 0; side < 2; ++side)
+        {
+            const auto pole = poles[(size_t) (2 * m + side)];
+            const auto otherPole = poles[(size_t) (2 * m + 1 - side)];
+            const auto w = 1.0 / pole;
+
+            Complex residue = 1.0 / (1.0 - otherPole * w);
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                residue *= getNumerator(sections[k], w);
+
+                if (k != m)
+                    residue /= getDenominator(sections[k], w);
+            }
+
+            residues[side] = residue;
+        }
+
+        // The pair's residues are conjugate (or both real), so the section's
+        // numerator comes out real.
+        const auto p = poles[(size_t) (2 * m)], q = poles[(size_t) (2 * m + 1)];
+        const auto i = (size_t) m;
+
+        result.c0[i] = (float) (residues[0] + residues[1]).real();
+        result.c1[i] = (float) -(residues[0] * q + residues[1] * p).real();
+        result.a1[i] = sections[m].a1;
+        result.a2[i] = sections[m].a2;
+    }
+
+    result.direct = (float) direct;
+    result.maxError = (float) getMaxError(sections, numSections, result);
+    result.valid = result.maxError < maxParallelError;
+
+    return result;
+}
+
+//==============================================================================
+void ParallelChain::reset() noexcept
+{
+    std::fill(getRow(s1Row), getRow(s2Row) + maxParallelSections, 0.0f);
+}
+
+bool ParallelChain::hasSameSections(const ParallelCoefficients& other) const noexcept
+{
+    return other.numSections == target.numSections && other.valid == target.valid;
+}
+
+void ParallelChain::setCoefficients(const ParallelCoefficients& newCoefficients) noexcept
+{
+    if (! hasSameSections(newCoefficients))
+        reset();
+
+    target = newCoefficients;
+    rampRemaining = 0;
+
+    std::copy(target.c0.begin(), target.c0.end(), getRow(c0Row));
+    std::copy(target.c1.begin(), target.c1.end(), getRow(c1Row));
+    std::copy(target.a1.begin(), target.a1.end(), getRow(a1Row));
+    std::copy(target.a2.begin(), target.a2.end(), getRow(a2Row));
+    direct = target.direct;
+}
+
+void ParallelChain::rampTo(const ParallelCoefficients& newCoefficients, int numSamples) noexcept
+{
+    if (numSamples <= 0 || ! hasSameSections(newCoefficients))
+    {
+        setCoefficients(newCoefficients);
+        return;
+    }
+
+    target = newCoefficients;
+    rampRemaining = numSamples;
+
+    const auto scale = 1.0f / (float) numSamples;
+    const std::array<const float*, numCoefficientRows> targetRows{ target.c0.data(), target.c1.data(),
+                                                                   target.a1.data(), target.a2.data() };
+
+    for (int row = 0; row < numCoefficientRows; ++row)
+    {
+        const auto* current = getRow(row);
+        const auto* to = targetRows[(size_t) row];
+        auto* increment = getRow(numCoefficientRows + row);
+
+        for (int i = 0; i < maxParallelSections; ++i)
+            increment[i] = (to[i] - current[i]) * scale;
+    }
+
+    directIncrement = (target.direct - direct) * scale;
+}
+
+void ParallelChain::process(float* samples, int numSamples) noexcept
+{
+    if (! target.valid)
+        return;
+
+    if (rampRemaining > 0)
+    {
+        const auto numInRamp = juce::jmin(rampRemaining, numSamples);
+        processSections<true>(samples, numInRamp);
+
+        samples += numInRamp;
+        numSamples -= numInRamp;
+        rampRemaining -= numInRamp;
+
+        // Land exactly on the target rather than wherever rounding has got to.
+        if (rampRemaining <= 0)
+            setCoefficients(target);
+    }
+
+    processSections<false>(samples, numSamples);
+}
+
+template <bool Ramping>
+void ParallelChain::processSections(float* samples, int numSamples) noexcept
+{
+    // Sections past numSections have zero coefficients and state, so whole
+    // groups of lanes can run regardless.
+    const auto numGroups = (target.numSections + numParallelLanes - 1) / numParallelLanes;
+
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    Vector c0[numParallelGroups], c1[numParallelGroups], a1[numParallelGroups], a2[numParallelGroups];
+    Vector c0Step[numParallelGroups], c1Step[numParallelGroups], a1Step[numParallelGroups], a2Step[numParallelGroups];
+    Vector s1[numParallelGroups], s2[numParallelGroups];
+
+    auto load = [this](int row, int group) { return Vector::fromRawArray(getRow(row) + group * numParallelLanes); };
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        c0[g] = load(c0Row, g);
+        c1[g] = load(c1Row, g);
+        a1[g] = load(a1Row, g);
+        a2[g] = load(a2Row, g);
+        s1[g] = load(s1Row, g);
+        s2[g] = load(s2Row, g);
+
+        if constexpr (Ramping)
+        {
+            c0Step[g] = load(numCoefficientRows + c0Row, g);
+            c1Step[g] = load(numCoefficientRows + c1Row, g);
+            a1Step[g] = load(numCoefficientRows + a1Row, g);
+            a2Step[g] = load(numCoefficientRows + a2Row, g);
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if constexpr (Ramping)
+        {
+            for (int g = 0; g < numGroups; ++g)
+            {
+                c0[g] = c0[g] + c0Step[g];
+                c1[g] = c1[g] + c1Step[g];
+                a1[g] = a1[g] + a1Step[g];
+                a2[g] = a2[g] + a2Step[g];
+            }
+
+            direct += directIncrement;
+        }
+
+        const auto x = samples[i];
+        const auto input = Vector::expand(x);
+        auto sum = Vector::expand(0.0f);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const auto y = c0[g] * input + s1[g];
+            s1[g] = c1[g] * input - a1[g] * y + s2[g];
+            s2[g] = Vector::expand(0.0f) - a2[g] * y;
+            sum = sum + y;
+        }
+
+        samples[i] = direct * x + sum.sum();
+    }
+
+    for (int g = 0; g < numGroups; ++g)
+    {
+        auto store = [this, g](int row, Vector value) { value.copyToRawArray(getRow(row) + g * numParallelLanes); };
+
+        store(s1Row, s1[g]);
+        store(s2Row, s2[g]);
+
+        if constexpr (Ramping)
+        {
+            store(c0Row, c0[g]);
+            store(c1Row, c1[g]);
+            store(a1Row, a1[g]);
+            store(a2Row, a2[g]);
+        }
+    }
+   #else
+    auto* c0 = getRow(c0Row);
+    auto* c1 = getRow(c1Row);
+    auto* a1 = getRow(a1Row);
+    auto* a2 = getRow(a2Row);
+    auto* s1 = getRow(s1Row);
+    auto* s2 = getRow(s2Row);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if constexpr (Ramping)
+        {
+            for (int row = 0; row < numCoefficientRows; ++row)
+                for (int k = 0; k < maxParallelSections; ++k)
+                    getRow(row)[k] += getRow(numCoefficientRows + row)[k];
+
+            direct += directIncrement;
+        }
+
+        const auto x = samples[i];
+        auto sum = direct * x;
+
+        for (int k = 0; k < numGroups; ++k)
+        {
+            const auto y = c0[k] * x + s1[k];
+            s1[k] = c1[k] * x - a1[k] * y + s2[k];
+            s2[k] = -a2[k] * y;
+            sum += y;
+        }
+
+        samples[i] = sum;
+    }
+   #endif
+
+    for (int k = 0; k < maxParallelSections; ++k)
+    {
+        juce::dsp::util::snapToZero(getRow(s1Row)[k]);
+        juce::dsp::util::snapToZero(getRow(s2Row)[k]);
+    }
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    ParallelForm.h
+
+    The whole chain's response as a sum of independent second order sections
+    plus a direct term, instead of a cascade.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+#if JUCE_USE_SIMD
+ constexpr int numParallelLanes = (int) juce::dsp::SIMDRegister<float>::SIMDNumElements;
+#else
+ constexpr int numParallelLanes = 1;
+#endif
+
+/** Enough lane groups for every section a chain can have. */
+constexpr int numParallelGroups = (maxChainSections + numParallelLanes - 1) / numParallelLanes;
+constexpr int maxParallelSections = numParallelGroups * numParallelLanes;
+
+/**
+    The partial fraction expansion of a chain's transfer function,
+
+        H(z) = direct + sum of (c0 + c1 z^-1) / (1 + a1 z^-1 + a2 z^-2)
+
+    with one section per section of the cascade, keeping its poles. Each
+    section sees the input rather than the one before's output, so they can
+    all run at once, side by side in SIMD lanes, and be summed.
+
+    The expansion is worked out in double precision, and then checked by
+    comparing its response, with the coefficients rounded to float as they
+    will be run, to the cascade's at a spread of frequencies. Where poles
+    crowd together (a low cut near the bottom of the range, or a peak landing
+    on a cut's poles) the residues grow large and cancel, and float can't
+    hold them; then valid is false and the cascade should be run instead.
+
+    Plain data, so it can be handed over in a snapshot. The coefficients are
+    stored as a structure of arrays; sections past numSections are zero.
+*/
+struct ParallelCoefficients
+{
+    float direct{ 1 };
+    int numSections{ 0 };
+    bool valid{ false };
+    /** The largest difference from the cascade's response found by the check,
+        relative to the response or to unity, whichever is larger.
+    */
+    float maxError{ 0 };
+    std::array<float, maxParallelSections> c0{}, c1{}, a1{}, a2{};
+};
+
+static_assert(std::is_trivially_copyable<ParallelCoefficients>::value, "");
+
+/** The largest maxError that still counts as valid, i.e. -60 dB. */
+constexpr double maxParallelError = 1.0e-3;
+
+ParallelCoefficients makeParallelCoefficients(const ChainCoefficients& coefficients) noexcept;
+/** The same for any cascade of sections, up to maxChainSections of them. */
+ParallelCoefficients makeParallelCoefficients(const BiquadCoefficients* sections, int numSections) noexcept;
+
+//==============================================================================
+/**
+    Runs one channel through a ParallelCoefficients realization. Like
+    BandGraph, it ramps to new coefficients itself.
+
+    Only valid coefficients should be processed; anything else leaves the
+    signal untouched.
+*/
+class ParallelChain
+{
+public:
+    ParallelChain() = default;
+
+    void reset() noexcept;
+
+    /** Switches to new coefficients straight away. The state is kept if the
+        number of sections is the same, and cleared otherwise.
+    */
+    void setCoefficients(const ParallelCoefficients& newCoefficients) noexcept;
+
+    /** Moves the coefficients linearly to the new ones over the next
+        numSamples samples. If the sections differ it jumps instead.
+    */
+    void rampTo(const ParallelCoefficients& newCoefficients, int numSamples) noexcept;
+
+    void process(float* samples, int numSamples) noexcept;
+
+    /** True if the new coefficients have the same sections as these and are
+        just as valid, so they can be ramped to.
+    */
+    bool hasSameSections(const ParallelCoefficients& other) const noexcept;
+
+    bool isValid() const noexcept { return target.valid; }
+    bool isRamping() const noexcept { return rampRemaining > 0; }
+
+private:
+    enum Row
+    {
+        c0Row, c1Row, a1Row, a2Row,
+        numCoefficientRows,
+        s1Row = 2 * numCoefficientRows, s2Row,
+        numRows
+    };
+
+    float* getRow(int row) noexcept { return block.data() + row * maxParallelSections; }
+
+    template <bool Ramping>
+    void processSections(float* samples, int numSamples) noexcept;
+
+    // The coefficient rows, then an increment for each of them, then the state.
+    alignas(64) std::array<float, numRows * maxParallelSections> block{};
+    float direct{ 1 }, directIncrement{ 0 };
+    ParallelCoefficients target;
+    int rampRemaining{ 0 };
+};
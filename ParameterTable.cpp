@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    ParameterTable.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterTable.h"
+
+namespace
+{
+    bool isBandParameter(int index) noexcept { return index >= numFixedParameters; }
+    int getBand(int index) noexcept { return 2 + (index - numFixedParameters) / numBandParameters; }
+
+    /** A "Graph ... Slope" choice of 0 keeps the chain's slope, and each one
+        after that is a stage more than the chain can have.
+    */
+    int getGraphCutStages(int graphSlopeChoice, Slope chainSlope) noexcept
+    {
+        if (graphSlopeChoice <= 0)
+            return (int) chainSlope + 1;
+
+        return juce::jlimit(1, maxButterworthStages, (int) Slope_48 + 1 + graphSlopeChoice);
+    }
+
+    juce::StringArray getChoices(ParameterChoices choices)
+    {
+        switch (choices)
+        {
+        case ParameterChoices::slopes:
+        case ParameterChoices::graphSlopes:
+        {
+            // The chain's four slopes must stay as they are, or saved values
+            // would land on different ones. The steeper ones have their own
+            // parameters, whose first choice defers to the chain's.
+            const auto isGraph = choices == ParameterChoices::graphSlopes;
+            juce::StringArray slopes;
+
+            if (isGraph)
+                slopes.add("As Chain");
+
+            const auto firstStage = isGraph ? (int) Slope_48 + 1 : 0;
+            const auto endStage = isGraph ? maxButterworthStages : (int) Slope_48 + 1;
+
+            for (int i = firstStage; i < endStage; ++i)
+                slopes.add(juce::String(12 + i * 12) + "db/Oct*");
+
+            return slopes;
+        }
+
+        case ParameterChoices::oversampling:    return { "1x", "2x", "4x" };
+        case ParameterChoices::engines:         return { "Biquad", "SVF", "Linear Phase", "Band Graph" };
+        case ParameterChoices::bandTypes:       return { "Off", "Peak", "Low Shelf", "High Shelf" };
+        case ParameterChoices::none:
+        default:                                return {};
+        }
+    }
+}
+
+const ParameterSpec& getParameterSpec(int index) noexcept
+{
+    jassert(index >= 0 && index < numParameters);
+
+    if (isBandParameter(index))
+        return bandParameterSpecs[(size_t) ((index - numFixedParameters) % numBandParameters)];
+
+    return fixedParameterSpecs[(size_t) index];
+}
+
+juce::String getParameterID(int index)
+{
+    if (isBandParameter(index))
+        return "Band " + juce::String(getBand(index)) + " " + getParameterSpec(index).id;
+
+    return getParameterSpec(index).id;
+}
+
+float getParameterDefault(int index) noexcept
+{
+    if (isBandParameter(index) && (index - numFixedParameters) % numBandParameters == bandFreqParameter)
+        return std::round(20.f * std::pow(1000.f, (float) (getBand(index) - 1) / (float) maxGraphBands));
+
+    return getParameterSpec(index).defaultValue;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayoutFromTable()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    for (int index = 0; index < numParameters; ++index)
+    {
+        const auto& spec = getParameterSpec(index);
+        const auto id = getParameterID(index);
+
+        if (spec.choices == ParameterChoices::none)
+            layout.add(std::make_unique<juce::AudioParameterFloat>(id, id,
+                juce::NormalisableRange<float>(spec.minimum, spec.maximum, spec.interval, spec.skew), getParameterDefault(index)));
+        else
+            layout.add(std::make_unique<juce::AudioParameterChoice>(id, id, getChoices(spec.choices), (int) getParameterDefault(index)));
+    }
+
+    return layout;
+}
+
+//==============================================================================
+ParameterSnapshot ParameterSnapshot::getDefaults() noexcept
+{
+    ParameterSnapshot snapshot;
+
+    for (int index = 0; index < numParameters; ++index)
+        snapshot.values[(size_t) index] = getParameterDefault(index);
+
+    return snapshot;
+}
+
+ChainSettings ParameterSnapshot::getChainSettings() const noexcept
+{
+    ChainSettings settings;
+    settings.lowCutFreq = (*this)[lowCutFreqParameter];
+    settings.highCutFreq = (*this)[highCutFreqParameter];
+    settings.peakFreq = (*this)[peakFreqParameter];
+    settings.peakGaininDecibels = (*this)[peakGainParameter];
+    settings.peakQuality = (*this)[peakQualityParameter];
+    settings.lowCutSlope = static_cast<Slope>(juce::jlimit((int) Slope_12, (int) Slope_48, getChoice(lowCutSlopeParameter)));
+    settings.highCutSlope = static_cast<Slope>(juce::jlimit((int) Slope_12, (int) Slope_48, getChoice(highCutSlopeParameter)));
+    return settings;
+}
+
+BandGraphSettings ParameterSnapshot::getBandGraphSettings() const noexcept
+{
+    BandGraphSettings settings;
+    const auto chain = getChainSettings();
+    applyChainSettings(settings, chain);
+
+    settings.lowCutStages = getGraphCutStages(getChoice(graphLowCutSlopeParameter), chain.lowCutSlope);
+    settings.highCutStages = getGraphCutStages(getChoice(graphHighCutSlopeParameter), chain.highCutSlope);
+
+    for (int band = 2; band <= maxGraphBands; ++band)
+    {
+        auto& bandSettings = settings.bands[(size_t) (band - 1)];
+        bandSettings.type = static_cast<BandType>(juce::jlimit(0, 3, getChoice(getBandParameterIndex(band, bandTypeParameter))));
+        bandSettings.frequency = (*this)[getBandParameterIndex(band, bandFreqParameter)];
+        bandSettings.gainInDecibels = (*this)[getBandParameterIndex(band, bandGainParameter)];
+        bandSettings.quality = (*this)[getBandParameterIndex(band, bandQualityParameter)];
+    }
+
+    return settings;
+}
+
+FilterEngine ParameterSnapshot::getEngine() const noexcept
+{
+    return static_cast<FilterEngine>(juce::jlimit(0, 3, getChoice(filterEngineParameter)));
+}
+
+int ParameterSnapshot::getOversamplingOrder() const noexcept
+{
+    return juce::jlimit(0, 2, getChoice(oversamplingParameter));
+}
+
+//==============================================================================
+CachedParameters::CachedParameters(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int index = 0; index < numParameters; ++index)
+    {
+        values[(size_t) index] = apvts.getRawParameterValue(getParameterID(index));
+        jassert(values[(size_t) index] != nullptr);
+    }
+}
+
+void CachedParameters::read(ParameterSnapshot& snapshot) const noexcept
+{
+    snapshot.generation = getGeneration();
+
+    for (size_t i = 0; i < values.size(); ++i)
+        snapshot.values[i] = values[i]->load(std::memory_order_relaxed);
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    ParameterTable.h
+
+    The plugin's parameters as one compile-time table, and a typed, cached
+    way to read them without looking anything up by name.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BandGraph.h"
+
+/** Which implementation runs the chain, chosen by the "Filter Engine"
+    parameter. All produce the same magnitude response.
+*/
+enum class FilterEngine
+{
+    biquad,     // direct form biquads, processed several channels per SIMD register
+    svf,        // trapezoidal state variable filters, accurate in float at low cutoffs
+    linearPhase,// an FIR with no phase shift, at the cost of latency; never oversampled
+    bandGraph   // the only engine with the extra bands and cuts steeper than 48 dB/oct
+};
+
+/** The fixed parameters, in the order they're added to the layout. */
+enum ParameterIndex
+{
+    lowCutFreqParameter,
+    highCutFreqParameter,
+    peakFreqParameter,
+    peakGainParameter,
+    peakQualityParameter,
+    lowCutSlopeParameter,
+    highCutSlopeParameter,
+    oversamplingParameter,
+    filterEngineParameter,
+    graphLowCutSlopeParameter,
+    graphHighCutSlopeParameter,
+    numFixedParameters
+};
+
+/** Each of bands 2 to maxGraphBands has these, after the fixed parameters.
+    Band 1 is the Peak parameters.
+*/
+enum BandParameter
+{
+    bandTypeParameter,
+    bandFreqParameter,
+    bandGainParameter,
+    bandQualityParameter,
+    numBandParameters
+};
+
+constexpr int numParameters = numFixedParameters + (maxGraphBands - 1) * numBandParameters;
+
+constexpr int getBandParameterIndex(int band, BandParameter parameter) noexcept
+{
+    return numFixedParameters + (band - 2) * numBandParameters + (int) parameter;
+}
+
+enum class ParameterChoices
+{
+    none,           // a float parameter
+    slopes,         // 12 to 48 dB/oct, which every engine can do
+    graphSlopes,    // the Band Graph's cuts: as the slopes above, or steeper
+    oversampling,
+    engines,
+    bandTypes
+};
+
+/** A float parameter's range and default, or a choice parameter's list and
+    default index. A band parameter's id is its suffix after "Band N ".
+*/
+struct ParameterSpec
+{
+    const char* id;
+    ParameterChoices choices;
+    float minimum, maximum, interval, skew, defaultValue;
+};
+
+constexpr std::array<ParameterSpec, numFixedParameters> fixedParameterSpecs
+{ {
+    { "LowCut Freq",         ParameterChoices::none,         20.f,   20000.f,    1.f,    0.25f,  20.f },
+    { "HighCut Freq",        ParameterChoices::none,         20.f,   20000.f,    1.f,    0.25f,  20000.f },
+    { "Peak Freq",           ParameterChoices::none,         20.f,   20000.f,    1.f,    0.25f,  750.f },
+    { "Peak Gain",           ParameterChoices::none,         -24.f,  24.f,       0.5f,   1.f,    0.f },
+    { "Peak Quality",        ParameterChoices::none,         0.1f,   10.f,       0.05f,  1.f,    1.f },
+    { "LowCut Slope",        ParameterChoices::slopes,       0,      0,          0,      0,      0 },
+    { "HighCut Slope",       ParameterChoices::slopes,       0,      0,          0,      0,      0 },
+    { "Oversampling",        ParameterChoices::oversampling, 0,      0,          0,      0,      0 },
+    { "Filter Engine",       ParameterChoices::engines,      0,      0,          0,      0,      0 },
+    { "Graph LowCut Slope",  ParameterChoices::graphSlopes,  0,      0,          0,      0,      0 },
+    { "Graph HighCut Slope", ParameterChoices::graphSlopes,  0,      0,          0,      0,      0 }
+} };
+
+// The extra bands start switched off. Their frequencies are spread evenly
+// over the range by getParameterDefault() rather than taken from here.
+constexpr std::array<ParameterSpec, numBandParameters> bandParameterSpecs
+{ {
+    { "Type",                ParameterChoices::bandTypes,    0,      0,          0,      0,      0 },
+    { "Freq",                ParameterChoices::none,         20.f,   20000.f,    1.f,    0.25f,  0.f },
+    { "Gain",                ParameterChoices::none,         -24.f,  24.f,       0.5f,   1.f,    0.f },
+    { "Quality",             ParameterChoices::none,         0.1f,   10.f,       0.05f,  1.f,    1.f }
+} };
+
+const ParameterSpec& getParameterSpec(int index) noexcept;
+juce::String getParameterID(int index);
+/** The unnormalised default, which for a choice is its index. */
+float getParameterDefault(int index) noexcept;
+
+/** Builds the layout from the table, so the ids and order always match it. */
+juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayoutFromTable();
+
+/**
+    Every parameter's unnormalised value, packed in table order and read in
+    one pass, stamped with the generation of CachedParameters it was read at.
+    Two snapshots with the same generation hold the same values.
+*/
+struct ParameterSnapshot
+{
+    juce::uint32 generation{ 0 };
+    std::array<float, numParameters> values{};
+
+    /** A snapshot of the defaults, with generation 0. */
+    static ParameterSnapshot getDefaults() noexcept;
+
+    float operator[](int index) const noexcept { return values[(size_t) index]; }
+    int getChoice(int index) const noexcept { return (int) values[(size_t) index]; }
+
+    /** The chain stops at 48 dB/oct; only the Band Graph engine goes steeper. */
+    ChainSettings getChainSettings() const noexcept;
+    /** Everything the Band Graph engine uses: the chain's parameters, the
+        extra "Band N" parameters, and the "Graph ... Slope" parameters,
+        which either leave a cut's slope as it is or take it up to 96 dB/oct.
+    */
+    BandGraphSettings getBandGraphSettings() const noexcept;
+    FilterEngine getEngine() const noexcept;
+    int getOversamplingOrder() const noexcept;
+};
+
+/**
+    The apvts's value of every parameter in the table, resolved to a pointer
+    once, when it's made, so reading them takes no string lookups.
+
+    The generation counts changes. Anything that calls markChanged() when a
+    parameter or other design input changes lets readers see whether
+    there's anything new with one integer compare, before reading a value.
+*/
+class CachedParameters
+{
+public:
+    explicit CachedParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    /** Any thread, including the audio thread. */
+    void markChanged() noexcept { generation.fetch_add(1, std::memory_order_release); }
+    juce::uint32 getGeneration() const noexcept { return generation.load(std::memory_order_acquire); }
+
+    float get(int index) const noexcept { return values[(size_t) index]->load(std::memory_order_relaxed); }
+
+    /** Reads every value into snapshot. The generation is read first, so a
+        change that races with the read is picked up again next time.
+    */
+    void read(ParameterSnapshot& snapshot) const noexcept;
+
+private:
+    std::array<std::atomic<float>*, numParameters> values{};
+    // Starts ahead of any consumer's "last seen", so the first read counts.
+    std::atomic<juce::uint32> generation{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE(CachedParameters)
+};
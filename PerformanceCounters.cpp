@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    PerformanceCounters.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceCounters.h"
+
+namespace
+{
+    double ticksToMicroseconds(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    const char* getEventName(PerformanceCounters::Event event) noexcept
+    {
+        switch (event)
+        {
+        case PerformanceCounters::Event::processBlock:  return "processBlock";
+        case PerformanceCounters::Event::audioDesign:   return "audioDesign";
+        case PerformanceCounters::Event::publishDesign: return "publishDesign";
+        case PerformanceCounters::Event::chainDesign:   return "chainDesign";
+        case PerformanceCounters::Event::editorRefresh: return "editorRefresh";
+        case PerformanceCounters::Event::numEvents:
+        default:                                        return "unknown";
+        }
+    }
+}
+
+void PerformanceCounters::record(Event event, juce::int64 startTicks, juce::int64 endTicks, int numSamples) noexcept
+{
+    const auto duration = endTicks - startTicks;
+    auto& eventTotals = totals[(size_t) event];
+
+    eventTotals.count.fetch_add(1, std::memory_order_relaxed);
+    eventTotals.ticks.fetch_add(duration, std::memory_order_relaxed);
+
+    auto worst = eventTotals.worstTicks.load(std::memory_order_relaxed);
+
+    while (duration > worst && ! eventTotals.worstTicks.compare_exchange_weak(worst, duration, std::memory_order_relaxed))
+    {}
+
+    if (event == Event::processBlock)
+    {
+        const auto nanoseconds = (juce::int64) (juce::Time::highResolutionTicksToSeconds(duration) * 1.0e9);
+        blockHistogram[(size_t) getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto& slot = trace[(size_t) (traceWriteIndex.fetch_add(1, std::memory_order_relaxed) & (traceSize - 1))];
+
+    // Only possible if another thread has lapped the whole ring meanwhile;
+    // drop this event rather than wait.
+    if (slot.writing.test_and_set(std::memory_order_acquire))
+        return;
+
+    const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.event.store((int) event, std::memory_order_relaxed);
+    slot.numSamples.store(numSamples, std::memory_order_relaxed);
+    slot.startTicks.store(startTicks, std::memory_order_relaxed);
+    slot.endTicks.store(endTicks, std::memory_order_relaxed);
+    slot.onMessageThread.store(juce::MessageManager::existsAndIsCurrentThread(), std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    slot.writing.clear(std::memory_order_release);
+}
+
+int PerformanceCounters::getBucket(juce::int64 nanoseconds) noexcept
+{
+    const auto value = (juce::uint32) juce::jlimit((juce::int64) 0, (juce::int64) 0xffffffff, nanoseconds);
+
+    if (value < 8)
+        return (int) value;
+
+    // The top bit picks the octave and the three below it the eighth.
+    const auto topBit = juce::findHighestSetBit(value);
+    return 8 + (topBit - 3) * 8 + (int) ((value >> (topBit - 3)) & 7);
+}
+
+double PerformanceCounters::getBucketMicroseconds(int bucket) noexcept
+{
+    if (bucket < 8)
+        return (bucket + 1) * 1.0e-3;
+
+    // The top of the bucket, so percentiles err on the slow side.
+    const auto topBit = (bucket - 8) / 8 + 3;
+    const auto eighth = (bucket - 8) % 8;
+    return std::ldexp(9.0 + eighth, topBit - 3) * 1.0e-3;
+}
+
+double PerformanceCounters::getBlockPercentile(double fraction) const noexcept
+{
+    std::array<juce::uint32, numBuckets> counts;
+    juce::uint64 total = 0;
+
+    for (size_t i = 0; i < counts.size(); ++i)
+        total += counts[i] = blockHistogram[i].load(std::memory_order_relaxed);
+
+    if (total == 0)
+        return 0;
+
+    const auto target = (juce::uint64) std::ceil(fraction * (double) total);
+    juce::uint64 count = 0;
+
+    for (int i = 0; i < numBuckets; ++i)
+        if ((count += counts[(size_t) i]) >= target)
+            return getBucketMicroseconds(i);
+
+    return getBucketMicroseconds(numBuckets - 1);
+}
+
+PerformanceCounters::Summary PerformanceCounters::getSummary() const noexcept
+{
+    auto getTotals = [this](Event event) -> const Totals& { return totals[(size_t) event]; };
+    auto getSeconds = [&](Event event) { return juce::Time::highResolutionTicksToSeconds(getTotals(event).ticks.load(std::memory_order_relaxed)); };
+
+    Summary summary;
+    summary.numBlocks = getTotals(Event::processBlock).count.load(std::memory_order_relaxed);
+    summary.numAudioDesigns = getTotals(Event::audioDesign).count.load(std::memory_order_relaxed);
+    summary.numPublishedDesigns = getTotals(Event::publishDesign).count.load(std::memory_order_relaxed);
+    summary.numEditorRefreshes = getTotals(Event::editorRefresh).count.load(std::memory_order_relaxed);
+    summary.numChainDesigns = getTotals(Event::chainDesign).count.load(std::memory_order_relaxed);
+
+    summary.blockMicroseconds50 = getBlockPercentile(0.5);
+    summary.blockMicroseconds95 = getBlockPercentile(0.95);
+    summary.blockMicroseconds99 = getBlockPercentile(0.99);
+    summary.worstBlockMicroseconds = ticksToMicroseconds(getTotals(Event::processBlock).worstTicks.load(std::memory_order_relaxed));
+
+    summary.audioDesignSeconds = getSeconds(Event::audioDesign);
+    summary.filterSeconds = juce::jmax(0.0, getSeconds(Event::processBlock) - summary.audioDesignSeconds);
+    summary.publishDesignSeconds = getSeconds(Event::publishDesign);
+    summary.chainDesignSeconds = getSeconds(Event::chainDesign);
+    summary.editorSeconds = getSeconds(Event::editorRefresh);
+    return summary;
+}
+
+void PerformanceCounters::reset() noexcept
+{
+    for (auto& eventTotals : totals)
+    {
+        eventTotals.count.store(0, std::memory_order_relaxed);
+        eventTotals.ticks.store(0, std::memory_order_relaxed);
+        eventTotals.worstTicks.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& bucket : blockHistogram)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+std::vector<PerformanceCounters::TraceEvent> PerformanceCounters::readTrace() const
+{
+    std::vector<TraceEvent> events;
+    events.reserve((size_t) traceSize);
+
+    for (const auto& slot : trace)
+    {
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence == 0 || (sequence & 1) != 0)
+            continue;
+
+        TraceEvent event{ static_cast<Event>(slot.event.load(std::memory_order_relaxed)),
+                          slot.numSamples.load(std::memory_order_relaxed),
+                          slot.startTicks.load(std::memory_order_relaxed),
+                          slot.endTicks.load(std::memory_order_relaxed),
+                          slot.onMessageThread.load(std::memory_order_relaxed) };
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+            events.push_back(event);
+    }
+
+    std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.startTicks < b.startTicks; });
+    return events;
+}
+
+bool PerformanceCounters::writeTrace(const juce::File& file) const
+{
+    const auto events = readTrace();
+    juce::FileOutputStream out(file);
+
+    if (! out.openedOk())
+        return false;
+
+    out.setPosition(0);
+    out.truncate();
+
+    const auto origin = events.empty() ? 0 : events.front().startTicks;
+    constexpr int audioTrack = 1, messageTrack = 2;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << audioTrack << ",\"args\":{\"name\":\"Audio\"}},\n"
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << messageTrack << ",\"args\":{\"name\":\"Message\"}}";
+
+    // By the thread that recorded it, not the kind of event, since an
+    // offline render publishes designs from inside processBlock.
+    for (const auto& event : events)
+    {
+        out << ",\n{\"name\":\"" << getEventName(event.event) << "\",\"ph\":\"X\",\"pid\":1"
+            << ",\"tid\":" << (event.onMessageThread ? messageTrack : audioTrack)
+            << ",\"ts\":" << juce::String(ticksToMicroseconds(event.startTicks - origin), 3)
+            << ",\"dur\":" << juce::String(ticksToMicroseconds(event.endTicks - event.startTicks), 3);
+
+        if (event.numSamples > 0)
+            out << ",\"args\":{\"numSamples\":" << event.numSamples << "}";
+
+        out << "}";
+    }
+
+    out << "\n]}\n";
+    out.flush();
+
+    return ! out.getStatus().failed();
+}
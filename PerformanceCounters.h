@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    PerformanceCounters.h
+
+    Per-instance timing of the audio callback, the coefficient designs and
+    the editor, cheap enough to leave running in a session.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Any thread may record an event: a couple of relaxed atomic adds for its
+    totals, a histogram bucket for blocks, and a slot in a ring of the most
+    recent events. Recording never locks or allocates, so it's safe on the
+    audio thread. Everything else is for the message thread.
+
+    The ring's slots are guarded by sequence counters, as in CutDesignCache,
+    so a reader that races with a writer just skips the slot it was on.
+*/
+class PerformanceCounters
+{
+public:
+    enum class Event
+    {
+        processBlock,   // one whole audio callback
+        audioDesign,    // coefficients stepped and applied during a glide, within a block
+        publishDesign,  // a new set of coefficients designed and published
+        chainDesign,    // the design functions alone, within a publishDesign
+        editorRefresh,  // the response curve picking up new coefficients
+        numEvents
+    };
+
+    PerformanceCounters() = default;
+
+    /** Records an event that ran from startTicks to endTicks, as given by
+        juce::Time::getHighResolutionTicks(). numSamples is the block size.
+        Which thread called is recorded along with it.
+    */
+    void record(Event event, juce::int64 startTicks, juce::int64 endTicks, int numSamples = 0) noexcept;
+
+    /** Times the enclosing scope as one event. */
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(PerformanceCounters& c, Event e, int n = 0) noexcept
+            : counters(c), event(e), numSamples(n), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedEvent() { counters.record(event, startTicks, juce::Time::getHighResolutionTicks(), numSamples); }
+
+    private:
+        PerformanceCounters& counters;
+        const Event event;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+
+    struct Summary
+    {
+        juce::int64 numBlocks{ 0 }, numPublishedDesigns{ 0 }, numAudioDesigns{ 0 }, numEditorRefreshes{ 0 };
+        juce::int64 numChainDesigns{ 0 };
+        double blockMicroseconds50{ 0 }, blockMicroseconds95{ 0 }, blockMicroseconds99{ 0 }, worstBlockMicroseconds{ 0 };
+        /** Totals in seconds. Filtering is the blocks' time less the designs
+            done inside them.
+        */
+        double filterSeconds{ 0 }, audioDesignSeconds{ 0 }, publishDesignSeconds{ 0 }, editorSeconds{ 0 };
+        /** The part of publishDesignSeconds spent in the design functions. */
+        double chainDesignSeconds{ 0 };
+    };
+
+    /** Message thread: totals since the last reset(). Percentiles are to
+        within an eighth of an octave.
+    */
+    Summary getSummary() const noexcept;
+
+    /** Message thread: starts the totals and histogram again. The trace ring
+        is kept.
+    */
+    void reset() noexcept;
+
+    /** Message thread: writes the events still in the ring as a Chrome trace,
+        which chrome://tracing and ui.perfetto.dev both open. Events recorded
+        on the message thread are on one track, and the rest, e.g. designs an
+        offline render does inside its audio callbacks, on the audio track.
+    */
+    bool writeTrace(const juce::File& file) const;
+
+    static constexpr int traceSize = 4096;   // events, a power of two
+    static constexpr int numBuckets = 240;
+
+private:
+    struct Totals
+    {
+        std::atomic<juce::int64> count{ 0 }, ticks{ 0 }, worstTicks{ 0 };
+    };
+
+    struct TraceSlot
+    {
+        std::atomic<juce::uint32> sequence{ 0 };
+        std::atomic_flag writing = ATOMIC_FLAG_INIT;
+        std::atomic<int> event{ 0 }, numSamples{ 0 };
+        std::atomic<juce::int64> startTicks{ 0 }, endTicks{ 0 };
+        std::atomic<bool> onMessageThread{ false };
+    };
+
+    struct TraceEvent
+    {
+        Event event;
+        int numSamples;
+        juce::int64 startTicks, endTicks;
+        bool onMessageThread;
+    };
+
+    // Blocks are bucketed by nanoseconds with eight buckets per octave.
+    static int getBucket(juce::int64 nanoseconds) noexcept;
+    static double getBucketMicroseconds(int bucket) noexcept;
+    double getBlockPercentile(double fraction) const noexcept;
+    std::vector<TraceEvent> readTrace() const;
+
+    std::array<Totals, (size_t) Event::numEvents> totals;
+    std::array<std::atomic<juce::uint32>, numBuckets> blockHistogram{};
+    std::array<TraceSlot, traceSize> trace;
+    std::atomic<juce::uint32> traceWriteIndex{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(PerformanceCounters)
+};
@@ -9,60 +9,231 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-ResponseCurveComponent::ResponseCurveComponent(NewProjectAudioProcessor& p) :audioProcessor(p)
+ResponseCurveComponent::ResponseCurveComponent(NewProjectAudioProcessor& p) :audioProcessor(p),
+    analyser({ &p.getPreEqFifo(), &p.getPostEqFifo() })
 {
-    const auto& params = audioProcessor.getParameters();
-    for (auto param : params)
+    audioProcessor.addCoefficientListener(this);
+
+    analyser.addChangeListener(this);
+    analyser.start({});
+    audioProcessor.setAnalyserEnabled(true);
+}
+
+ResponseCurveComponent::~ResponseCurveComponent() {
+    audioProcessor.setAnalyserEnabled(false);
+    analyser.stop();
+    analyser.removeChangeListener(this);
+
+    audioProcessor.removeCoefficientListener(this);
+}
+
+void ResponseCurveComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    if (source == &analyser)
     {
-        param->addListener(this);
+        auto changed = false;
+
+        for (int i = 0; i < (int) spectra.size(); ++i)
+            changed = analyser.getSpectrum(i, spectra[(size_t) i]) || changed;
+
+        if (changed)
+            repaint();
+
+        return;
     }
-    startTimerHz(60);
+
+    refresh();
 }
 
-ResponseCurveComponent::~ResponseCurveComponent() {
-    const auto& params = audioProcessor.getParameters();
+void ResponseCurveComponent::refresh()
+{
+    // The processor designs the coefficients once per change; we only pick up
+    // the same snapshot the audio thread uses, and only the bands that moved
+    // are re-evaluated.
+    auto generation = audioProcessor.getCoefficientGeneration();
 
-    for (auto param : params)
+    if (generation != coefficientGeneration)
     {
-        param->removeListener(this);
+        const PerformanceCounters::ScopedEvent refreshEvent(audioProcessor.getPerformanceCounters(),
+                                                            PerformanceCounters::Event::editorRefresh);
+        coefficientGeneration = generation;
+
+        // The coefficients may be for an oversampled rate; the analyser sees
+        // the host's.
+        const auto coefficients = audioProcessor.getLatestCoefficients();
+        analyser.setSampleRate(audioProcessor.getSampleRate());
+
+        const auto changed = audioProcessor.isBandGraphActive() ? responseCurve.update(audioProcessor.getLatestBandGraph())
+                                                                : responseCurve.update(coefficients);
+
+        if (changed)
+            repaint();
     }
 }
 
+void ResponseCurveComponent::resized()
+{
+    // One point per pixel column.
+    responseCurve.setFrequencies(getWidth(), 20.0, 20000.0);
+    coefficientGeneration = -1;
+    refresh();
+}
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+void ResponseCurveComponent::paint(juce::Graphics& g)
 {
-    parametersChanged.set(true);
+    using namespace juce;
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll(Colours::black);
+
+    drawSpectrum(g, spectra[preEqSpectrum], Colours::skyblue.withAlpha(0.4f));
+    drawSpectrum(g, spectra[postEqSpectrum], Colours::lightgreen.withAlpha(0.8f));
+
+    auto responseArea = getLocalBounds();
+    const auto numPoints = responseCurve.getNumPoints();
+
+    if (numPoints < 2 || responseArea.isEmpty())
+        return;
+
+    const auto* decibels = responseCurve.getMagnitudesInDecibels();
+    const double outputMin = responseArea.getBottom();
+    const double outputMax = responseArea.getY();
+    auto map = [outputMin, outputMax](double input)
+    {
+        return jmap(jlimit(-24.0, 24.0, input), -24.0, 24.0, outputMin, outputMax);
+    };
+
+    Path responseCurvePath;
+    responseCurvePath.preallocateSpace(numPoints * 3);
+    responseCurvePath.startNewSubPath((float) responseArea.getX(), (float) map(decibels[0]));
+
+    for (int i = 1; i < numPoints; ++i)
+        responseCurvePath.lineTo((float) (responseArea.getX() + i), (float) map(decibels[i]));
+
+    g.setColour(Colours::orange);
+    g.drawRoundedRectangle(responseArea.toFloat(), 4.f, 1.f);
 
+    g.setColour(Colours::white);
+    g.strokePath(responseCurvePath, PathStrokeType(2.f));
 }
 
-void ResponseCurveComponent::timerCallback()
+void ResponseCurveComponent::drawSpectrum(juce::Graphics& g, const SpectrumAnalyser::Spectrum& spectrum, juce::Colour colour)
 {
-    if (parametersChanged.compareAndSetBool(false, true))
+    using namespace juce;
+
+    if (spectrum.numBins < 2)
+        return;
+
+    // The response curve spans 20 Hz to 20 kHz across the width.
+    const auto area = getLocalBounds().toFloat();
+    auto xForFrequency = [&area](double frequency)
     {
-        DBG("params changed");
-        auto chainSettings = getChainSettings(audioProcessor.apvts);
-        auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-        updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-        auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
+        return area.getX() + area.getWidth() * (float) (std::log(frequency / 20.0) / std::log(1000.0));
+    };
+    auto yForDecibels = [&area](float decibels)
+    {
+        return jmap(jlimit(-72.f, 0.f, decibels), -72.f, 0.f, area.getBottom(), area.getY());
+    };
 
-        auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-        updateCutFilter(monoChain.get<ChainPositions::Lowcut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-        updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+    const auto ratio = spectrum.maxFrequency / spectrum.minFrequency;
+    Path spectrumPath;
+    spectrumPath.preallocateSpace(spectrum.numBins * 3);
 
-        repaint();
+    for (int i = 0; i < spectrum.numBins; ++i)
+    {
+        const auto frequency = spectrum.minFrequency * std::pow(ratio, (double) i / (spectrum.numBins - 1));
+        const Point<float> point(xForFrequency(frequency), yForDecibels(spectrum.decibels[(size_t) i]));
+
+        if (i == 0)
+            spectrumPath.startNewSubPath(point);
+        else
+            spectrumPath.lineTo(point);
     }
+
+    g.setColour(colour);
+    g.strokePath(spectrumPath, PathStrokeType(1.f));
 }
-void ResponseCurveComponent::paint(juce::Graphics& g)
+
+
+//==============================================================================
+PerformanceOverlay::PerformanceOverlay(PerformanceCounters& c) : counters(c)
+{
+    addAndMakeVisible(resetButton);
+    addAndMakeVisible(saveTraceButton);
+
+    resetButton.onClick = [this] { counters.reset(); };
+    saveTraceButton.onClick = [this] { saveTrace(); };
+}
+
+void PerformanceOverlay::visibilityChanged()
+{
+    // Nothing to poll while hidden.
+    if (isVisible())
+        startTimerHz(4);
+    else
+        stopTimer();
+}
+
+void PerformanceOverlay::timerCallback()
+{
+    summary = counters.getSummary();
+    repaint();
+}
+
+void PerformanceOverlay::resized()
+{
+    auto buttons = getLocalBounds().reduced(4).removeFromBottom(20);
+    saveTraceButton.setBounds(buttons.removeFromRight(80));
+    buttons.removeFromRight(4);
+    resetButton.setBounds(buttons.removeFromRight(50));
+}
+
+void PerformanceOverlay::paint(juce::Graphics& g)
 {
     using namespace juce;
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll(Colours::black);
 
-   
+    g.fillAll(Colours::black.withAlpha(0.75f));
+
+    auto milliseconds = [](double seconds) { return String(seconds * 1.0e3, 1) + " ms"; };
+    auto microseconds = [](double value) { return String(value, 1) + " us"; };
+
+    const StringArray lines{
+        "Blocks: " + String(summary.numBlocks)
+            + "   p50 " + microseconds(summary.blockMicroseconds50)
+            + "   p95 " + microseconds(summary.blockMicroseconds95)
+            + "   p99 " + microseconds(summary.blockMicroseconds99)
+            + "   worst " + microseconds(summary.worstBlockMicroseconds),
+        "Filtering: " + milliseconds(summary.filterSeconds)
+            + "   glide steps: " + milliseconds(summary.audioDesignSeconds) + " in " + String(summary.numAudioDesigns) + " blocks",
+        "Redesigns: " + String(summary.numPublishedDesigns) + " taking " + milliseconds(summary.publishDesignSeconds)
+            + " (" + milliseconds(summary.chainDesignSeconds) + " designing)"
+            + "   editor refreshes: " + String(summary.numEditorRefreshes) + " taking " + milliseconds(summary.editorSeconds)
+    };
+
+    g.setColour(Colours::white);
+    g.setFont(12.f);
+
+    auto area = getLocalBounds().reduced(6);
 
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(16), Justification::centredLeft);
 }
 
+void PerformanceOverlay::saveTrace()
+{
+    chooser = std::make_unique<juce::FileChooser>("Save Trace",
+                                                  juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile("EQ trace.json"),
+                                                  "*.json");
+
+    chooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting,
+                         [this](const juce::FileChooser& fc)
+    {
+        const auto file = fc.getResult();
 
+        if (file != juce::File() && ! counters.writeTrace(file))
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Save Trace",
+                                                   "Couldn't write " + file.getFullPathName());
+    });
+}
 
 //==============================================================================
 NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor(NewProjectAudioProcessor& p)
@@ -82,6 +253,17 @@ NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor(NewProjectAudioPr
     {
         addAndMakeVisible(comp);
     }
+
+    // The overlay sits over the response curve, hidden until asked for.
+    addChildComponent(performanceOverlay);
+    performanceButton.setClickingTogglesState(true);
+    performanceButton.onClick = [this]
+    {
+        performanceOverlay.setVisible(performanceButton.getToggleState());
+
+        // It shares the overlay's corner, and has to stay clickable to hide it.
+        performanceButton.toFront(false);
+    };
     
     setSize (600, 400);
 }
@@ -102,6 +284,8 @@ void NewProjectAudioProcessorEditor::resized()
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
 
     responseCurveComponent.setBounds(responseArea);
+    performanceOverlay.setBounds(responseArea);
+    performanceButton.setBounds(responseArea.removeFromTop(22).removeFromRight(50).reduced(2));
 
 
     auto lowCutArea = bounds.removeFromLeft(bounds.getWidth() * 0.33);
@@ -135,9 +319,10 @@ std::vector<juce::Component*> NewProjectAudioProcessorEditor::getComps()
     &highCutFreqSlider,
     &lowCutSlopeSlider,
     &highCutSlopeSlider,
-    &responseCurveComponent
+    &responseCurveComponent,
+    &performanceButton
 
     
     };
 
-}
\ No newline at end of file
+}
\ No newline at end of file
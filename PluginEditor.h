@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ResponseCurve.h"
+#include "SpectrumAnalyser.h"
 
 
 struct CustomRotarySlider :juce::Slider {
@@ -23,21 +25,51 @@ struct CustomRotarySlider :juce::Slider {
 //==============================================================================
 /**
 */
-struct ResponseCurveComponent :public juce::Component, public juce::AudioProcessorParameter::Listener,
-    public juce::Timer
+struct ResponseCurveComponent :public juce::Component,
+    public juce::ChangeListener
 {
     ResponseCurveComponent(NewProjectAudioProcessor&);
     ~ResponseCurveComponent();
-    void parameterValueChanged(int parameterIndex, float newValue)override;
-    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting)override;
 
-    void timerCallback()override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source)override;
     void paint(juce::Graphics& g) override;
+    void resized() override;
 private:
     NewProjectAudioProcessor& audioProcessor;
-    juce::Atomic<bool>parametersChanged{ false };
-    MonoChain monoChain;
+    int coefficientGeneration{ -1 };
+    ResponseCurve responseCurve;
+
+    // Spectra of the input and output, analysed while this component exists.
+    enum { preEqSpectrum, postEqSpectrum };
+    SpectrumAnalyser analyser;
+    std::array<SpectrumAnalyser::Spectrum, 2> spectra;
+
+    // Picks up the latest snapshot and repaints if the curve changed.
+    void refresh();
+    void drawSpectrum(juce::Graphics& g, const SpectrumAnalyser::Spectrum& spectrum, juce::Colour colour);
+
+};
+
+/** Shows an instance's PerformanceCounters over the response curve, and
+    saves its recent events as a trace.
+*/
+struct PerformanceOverlay :public juce::Component,
+    private juce::Timer
+{
+    explicit PerformanceOverlay(PerformanceCounters&);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+private:
+    PerformanceCounters& counters;
+    PerformanceCounters::Summary summary;
+
+    juce::TextButton resetButton{ "Reset" }, saveTraceButton{ "Save Trace..." };
+    std::unique_ptr<juce::FileChooser> chooser;
 
+    void timerCallback() override;
+    void saveTrace();
 };
 
 class NewProjectAudioProcessorEditor  : public juce::AudioProcessorEditor
@@ -72,6 +104,8 @@ private:
         highCutSlopeSliderAttachment;
 
     ResponseCurveComponent responseCurveComponent;
+    PerformanceOverlay performanceOverlay{ audioProcessor.getPerformanceCounters() };
+    juce::TextButton performanceButton{ "Stats" };
 
 
     std::vector<juce::Component*> getComps();
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "CascadeKernel.h"
 
 
 //==============================================================================
@@ -23,10 +24,18 @@ NewProjectAudioProcessor::NewProjectAudioProcessor()
                        )
 #endif
 {
+    for (auto* param : getParameters())
+        param->addListener(this);
+
+    startTimerHz(60);
 }
 
 NewProjectAudioProcessor::~NewProjectAudioProcessor()
 {
+    stopTimer();
+
+    for (auto* param : getParameters())
+        param->removeListener(this);
 }
 
 //==============================================================================
@@ -64,7 +73,7 @@ bool NewProjectAudioProcessor::isMidiEffect() const
 
 double NewProjectAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int NewProjectAudioProcessor::getNumPrograms()
@@ -101,45 +110,86 @@ void NewProjectAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     spec.maximumBlockSize = samplesPerBlock;
     spec.numChannels = 1;
     spec.sampleRate = sampleRate;
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
-    /*auto chainSettings = getChainSettings(apvts);
-
-    updatePeakFilter(chainSettings);
-
-    
-    auto lowCutCoefficients= juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate,2*(chainSettings.lowCutSlope+1));
-
-    auto& leftLowCut = leftChain.get<ChainPositions::Lowcut>();
-    
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
 
-   
-    auto& rightLowCut = rightChain.get<ChainPositions::Lowcut>();
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate
-        , 2 * (chainSettings.highCutSlope + 1));
-
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    const auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    chains.resize((size_t) numChannels);
+    chainPointers.clear();
+    channelGroups.clear();
+    channelPointers.assign((size_t) numChannels, nullptr);
+    oversampledPointers.assign((size_t) numChannels, nullptr);
+    svfChains.resize((size_t) numChannels);
+    timeParallelCascades.resize((size_t) numChannels);
+    parallelChains.assign((size_t) numChannels, {});
+    activeChainKernel = chainKernel.load();
+
+    for (auto& svfChain : svfChains)
+        svfChain.reset();
+
+    bandGraphs.resize((size_t) numChannels);
+
+    for (auto& bandGraph : bandGraphs)
+        bandGraph.reset();
+
+    fadeChains.resize((size_t) numChannels);
+    fadeSvfChains.resize((size_t) numChannels);
+    fadeBandGraphs.resize((size_t) numChannels);
+    fadeParallelChains.assign((size_t) numChannels, {});
+    fadeChainPointers.clear();
+    fadePointers.assign((size_t) numChannels, nullptr);
+    fadeBuffer.setSize(numChannels, samplesPerBlock << maxOversamplingOrder);
+    fadeRemaining = 0;
+
+    for (auto& chain : fadeChains)
+    {
+        chain.prepare(spec);
+        fadeChainPointers.push_back(&chain);
+    }
 
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    silentSamples = 0;
+    processingSkipped = false;
 
-    
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& chain = chains[(size_t) channel];
+        chain.prepare(spec);
+        chainPointers.push_back(&chain);
+        channelGroups.push_back(getChannelGroup(layout.getTypeOfChannel(channel)));
+    }
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);*/
+    // Polyphase IIR half-band stages, with the latency rounded to whole
+    // samples so it can be reported to the host.
+    for (int order = 1; order <= maxOversamplingOrder; ++order)
+    {
+        auto& oversampler = oversamplers[(size_t) order];
+        oversampler = std::make_unique<juce::dsp::Oversampling<float>>((size_t) juce::jmax(1, numChannels), (size_t) order,
+                                                                       juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                       false, true);
+        oversampler->initProcessing((size_t) samplesPerBlock);
+        oversamplingLatency[(size_t) order] = juce::roundToInt(oversampler->getLatencyInSamples());
+    }
 
-    updateFilters();
+    // Prepared again by publishCoefficients() if it's the engine in use.
+    linearPhase.release();
+    linearPhaseKernels.assign((size_t) numChannels, 0);
 
+    // Forces the smoothers and oversampler to be set up by the first pull.
+    activeOversamplingOrder = -1;
 
+    // The audio thread isn't running yet, so we can take the first set of
+    // coefficients straight away rather than waiting for the next block.
+    claimParameterChanges();
+    publishCoefficients(true);
+    pullCoefficients(true);
 }
 
-
 void NewProjectAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    const juce::ScopedLock sl(designLock);
+    linearPhase.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -149,12 +199,9 @@ bool NewProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout works, from mono up to high order ambisonics, as long as
+    // there is at least one channel to process.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -170,6 +217,9 @@ bool NewProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 
 void NewProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    // Offline renders may design here, so only realtime blocks are checked.
+    const RealtimeSanitizer::ScopedRealtime realtime(! isNonRealtime());
+    const PerformanceCounters::ScopedEvent blockEvent(performanceCounters, PerformanceCounters::Event::processBlock, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -182,48 +232,248 @@ void NewProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     // this code if your algorithm always overwrites all the output channels.
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-   
-    
-    /*auto chainSettings = getChainSettings(apvts);
 
-    updatePeakFilter(chainSettings);
+    // When rendering offline the message thread may not keep up with the
+    // automation, so design here rather than lagging behind it.
+    if (isNonRealtime() && claimParameterChanges())
+        publishCoefficients(true);
+
+    pullCoefficients();
+
+    if (const auto kernel = chainKernel.load(); kernel != activeChainKernel)
+    {
+        activeChainKernel = kernel;
+
+        if (activeChainKernel == ChainKernel::timeParallel)
+            for (size_t channel = 0; channel < chains.size(); ++channel)
+                makeTimeParallelCascade(timeParallelCascades[channel], chains[channel]);
+
+        // Anything left here would be out of date by the time the parallel
+        // kernel was chosen again, so it waits for a fresh design instead.
+        if (activeChainKernel != ChainKernel::parallel)
+            for (auto& parallelChain : parallelChains)
+                parallelChain.setCoefficients({});
+    }
+
+    // Run the channels in groups as wide as a SIMD register, so each section
+    // is evaluated once per group rather than once per channel.
+    const auto numChannels = juce::jmin(totalNumInputChannels, buffer.getNumChannels(), (int) chains.size());
+    const auto numSamples = buffer.getNumSamples();
+    const auto analyse = analyserEnabled.get();
+
+    if (analyse)
+        preEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, numSamples);
+
+    // Once the input has been silent for longer than the filters take to
+    // ring out, the output is silent too, so there's nothing to run. Glides
+    // and crossfades are left to finish first so nothing is cut off.
+    silentSamples = isInputSilent(buffer, numChannels, numSamples) ? silentSamples + numSamples : 0;
+
+    if (silentSamples > tailLengthSamples && ! isSmoothing() && fadeRemaining == 0)
+    {
+        if (! processingSkipped)
+        {
+            // Start cleanly when the input comes back.
+            for (auto& chain : chains)
+                chain.reset();
+
+            for (auto& svfChain : svfChains)
+                svfChain.reset();
+
+            for (auto& bandGraph : bandGraphs)
+                bandGraph.reset();
+
+            for (auto& parallelChain : parallelChains)
+                parallelChain.reset();
+
+            if (activeEngine == FilterEngine::linearPhase)
+                linearPhase.reset();
+
+            for (auto& oversampler : oversamplers)
+                if (oversampler != nullptr)
+                    oversampler->reset();
+
+            processingSkipped = true;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.clear(channel, 0, numSamples);
+    }
+    else if (activeEngine == FilterEngine::linearPhase)
+    {
+        processingSkipped = false;
+        linearPhase.process(buffer.getArrayOfWritePointers(), linearPhaseKernels.data(), numChannels, numSamples);
+    }
+    else if (auto* oversampler = oversamplers[(size_t) juce::jmax(0, activeOversamplingOrder)].get())
+    {
+        processingSkipped = false;
+
+        juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+        auto oversampledBlock = oversampler->processSamplesUp(block);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            oversampledPointers[(size_t) channel] = oversampledBlock.getChannelPointer((size_t) channel);
+
+        processChains(oversampledPointers.data(), numChannels, (int) oversampledBlock.getNumSamples());
+        oversampler->processSamplesDown(block);
+    }
+    else
+    {
+        processingSkipped = false;
+        processChains(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+    }
+
+    if (analyse)
+        postEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, numSamples);
+}
 
-    
+void NewProjectAudioProcessor::processChains(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (! isSmoothing())
+    {
+        processWithEngine(channels, numChannels, numSamples);
+        return;
+    }
 
-    auto cutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, getSampleRate(), 2 * (chainSettings.lowCutSlope + 1));
+    // While a change is gliding, step the coefficients every few samples
+    // instead of once per block, so the cost is the same whatever the host's
+    // block size and sweeps don't zipper.
+    const auto interval = smoothingInterval.get();
 
-    auto& leftLowCut = leftChain.get<ChainPositions::Lowcut>();
-    updateCutFilter(leftLowCut, cutCoefficients, chainSettings.lowCutSlope);
-    
+    // The steps' design time is recorded as one event per call, starting
+    // with the first step, so a long glide doesn't flood the trace.
+    const auto designStart = juce::Time::getHighResolutionTicks();
+    juce::int64 designTicks = 0;
 
-    auto& rightLowCut = rightChain.get<ChainPositions::Lowcut>();
-    updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
+    for (int start = 0; start < numSamples; start += interval)
+    {
+        const auto numInStep = juce::jmin(interval, numSamples - start);
+        const auto stepStart = juce::Time::getHighResolutionTicks();
 
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, getSampleRate()
-        , 2 * (chainSettings.highCutSlope + 1));
+        if (activeLink == ChannelLink::linked)
+            smoothers[mainGroup].advance(numInStep);
+        else
+            for (auto& smoother : smoothers)
+                smoother.advance(numInStep);
 
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
+        applySmoothedCoefficients(numInStep);
+        designTicks += juce::Time::getHighResolutionTicks() - stepStart;
 
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+        for (int channel = 0; channel < numChannels; ++channel)
+            channelPointers[(size_t) channel] = channels[channel] + start;
 
+        processWithEngine(channelPointers.data(), numChannels, numInStep);
+    }
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    performanceCounters.record(PerformanceCounters::Event::audioDesign, designStart, designStart + designTicks);
+}
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);*/
+void NewProjectAudioProcessor::processWithEngine(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    const auto numInFade = juce::jmin(fadeRemaining, numSamples);
+
+    // The chains as they were before the change run on a copy of the input.
+    if (numInFade > 0)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            fadeBuffer.copyFrom(channel, 0, channels[channel], numInFade);
+            fadePointers[(size_t) channel] = fadeBuffer.getWritePointer(channel);
+        }
+
+        if (activeEngine == FilterEngine::svf)
+            for (int channel = 0; channel < numChannels; ++channel)
+                fadeSvfChains[(size_t) channel].process(fadePointers[(size_t) channel], numInFade);
+        else if (activeEngine == FilterEngine::bandGraph)
+            for (int channel = 0; channel < numChannels; ++channel)
+                fadeBandGraphs[(size_t) channel].process(fadePointers[(size_t) channel], numInFade);
+        else if (activeChainKernel == ChainKernel::parallel)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                if (auto& parallelChain = fadeParallelChains[(size_t) channel]; parallelChain.isValid())
+                    parallelChain.process(fadePointers[(size_t) channel], numInFade);
+                else
+                    processFused(fadeChains[(size_t) channel], fadePointers[(size_t) channel], numInFade);
+            }
+        }
+        else
+            processFusedChannels(fadeChainPointers.data(), fadePointers.data(), numChannels, numInFade);
+    }
 
+    if (activeEngine == FilterEngine::svf)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            svfChains[(size_t) channel].process(channels[channel], numSamples);
+    }
+    else if (activeEngine == FilterEngine::bandGraph)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            bandGraphs[(size_t) channel].process(channels[channel], numSamples);
+    }
+    else if (activeChainKernel == ChainKernel::timeParallel)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            processTimeParallel(chains[(size_t) channel], timeParallelCascades[(size_t) channel], channels[channel], numSamples);
+    }
+    else if (activeChainKernel == ChainKernel::parallel)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if (auto& parallelChain = parallelChains[(size_t) channel]; parallelChain.isValid())
+                parallelChain.process(channels[channel], numSamples);
+            else
+                processFused(chains[(size_t) channel], channels[channel], numSamples);
+        }
+    }
+    else
+    {
+        processFusedChannels(chainPointers.data(), channels, numChannels, numSamples);
+    }
+
+    if (numInFade > 0)
+    {
+        const auto start = fadeLength - fadeRemaining;
 
-    updateFilters();
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = channels[channel];
+            const auto* old = fadePointers[(size_t) channel];
 
+            for (int i = 0; i < numInFade; ++i)
+            {
+                const auto amount = (float) (start + i + 1) / (float) fadeLength;
+                samples[i] = old[i] + amount * (samples[i] - old[i]);
+            }
+        }
 
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+        fadeRemaining -= numInFade;
+    }
+}
+
+void NewProjectAudioProcessor::startBandFade() noexcept
+{
+    // Same sizes, so these copies don't allocate.
+    if (activeEngine == FilterEngine::svf)
+        fadeSvfChains = svfChains;
+    else if (activeEngine == FilterEngine::bandGraph)
+        fadeBandGraphs = bandGraphs;
+    else
+        fadeChains = chains;
+
+    if (activeEngine == FilterEngine::biquad && activeChainKernel == ChainKernel::parallel)
+        fadeParallelChains = parallelChains;
+
+    fadeRemaining = fadeLength;
+}
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+bool NewProjectAudioProcessor::isInputSilent(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) const noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        if (buffer.getMagnitude(channel, 0, numSamples) > silenceThreshold)
+            return false;
 
+    return true;
 }
 
 //==============================================================================
@@ -241,138 +491,526 @@ juce::AudioProcessorEditor* NewProjectAudioProcessor::createEditor()
 //==============================================================================
 void NewProjectAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
-         
+    // The ValueTree, which earlier versions restore from, followed by a
+    // compact table of the parameter values that this one restores from
+    // instead; see PluginState.h.
+    parameterState.write(apvts.copyState(), destData);
 }
 
 void NewProjectAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Only the parameters that change are set, and each one just flags the
+    // coefficients as dirty, so the design happens on the next timer tick
+    // (or in prepareToPlay) instead of here. A session restoring hundreds of
+    // instances doesn't wait for hundreds of designs in a row.
+    std::vector<float> values;
+
+    if (parameterState.read(data, (size_t) juce::jmax(0, sizeInBytes), values))
+        parameterState.apply(values);
+}
 
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid()) {
-        apvts.replaceState(tree);
-        updateFilters();
+bool NewProjectAudioProcessor::loadPreset(const PresetBank& bank, int index)
+{
+    if (index < 0 || index >= bank.getNumPresets())
+        return false;
+
+    auto values = parameterState.getDefaultValues();
+    bank.visitPreset(index, [&](juce::uint32 idHash, float value) { parameterState.setPlainValue(values, idHash, value); });
+    parameterState.apply(values);
+    return true;
+}
+
+ChannelGroup getChannelGroup(juce::AudioChannelSet::ChannelType type)
+{
+    using Set = juce::AudioChannelSet;
+
+    switch (type)
+    {
+    case Set::LFE:
+    case Set::LFE2:
+        return lfeGroup;
+
+    case Set::leftSurround:
+    case Set::rightSurround:
+    case Set::centreSurround:
+    case Set::leftSurroundSide:
+    case Set::rightSurroundSide:
+    case Set::leftSurroundRear:
+    case Set::rightSurroundRear:
+        return surroundGroup;
+
+    case Set::topMiddle:
+    case Set::topFrontLeft:
+    case Set::topFrontCentre:
+    case Set::topFrontRight:
+    case Set::topRearLeft:
+    case Set::topRearCentre:
+    case Set::topRearRight:
+    case Set::topSideLeft:
+    case Set::topSideRight:
+        return heightGroup;
+
+    default:
+        return mainGroup;
     }
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
-    ChainSettings settings;
+void NewProjectAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    // May be called on the audio thread, so just count the change; the
+    // design itself happens in timerCallback().
+    cachedParameters.markChanged();
+}
+
+void NewProjectAudioProcessor::timerCallback()
+{
+    flushCoefficientChanges();
+    releaseUnusedLinearPhase();
+}
+
+bool NewProjectAudioProcessor::claimParameterChanges() noexcept
+{
+    // The timer and an offline render's audio thread may both get here, but
+    // only one of them claims a given generation.
+    const auto generation = cachedParameters.getGeneration();
+    auto designed = designedGeneration.load(std::memory_order_relaxed);
+
+    return generation != designed && designedGeneration.compare_exchange_strong(designed, generation);
+}
+
+void NewProjectAudioProcessor::flushCoefficientChanges()
+{
+    if (claimParameterChanges())
+        publishCoefficients();
+}
+
+void NewProjectAudioProcessor::publishCoefficients(bool buildKernelsNow)
+{
+    if (getSampleRate() <= 0)
+        return;
+
+    const PerformanceCounters::ScopedEvent designEvent(performanceCounters, PerformanceCounters::Event::publishDesign);
+    const juce::ScopedLock sl(designLock);
+
+    // Every value is read once, in table order, with no lookups by name.
+    ParameterSnapshot parameters;
+    cachedParameters.read(parameters);
+
+    const auto chainSettings = parameters.getChainSettings();
+    const auto engine = parameters.getEngine();
+
+    // An FIR doesn't cramp near Nyquist, so there's nothing to oversample for.
+    const auto oversamplingOrder = engine == FilterEngine::linearPhase
+                                 ? 0 : juce::jmin(maxOversamplingOrder, parameters.getOversamplingOrder());
+    const auto sampleRate = getSampleRate() * (1 << oversamplingOrder);
+
+    BusCoefficients coefficients;
+    coefficients.link = channelLink;
+    coefficients.oversamplingOrder = oversamplingOrder;
+    coefficients.engine = engine;
+    coefficients.generation = coefficientGeneration.get() + 1;
+
+    // The design functions on their own, apart from the reading, publishing
+    // and kernel requests around them.
+    const auto designStart = juce::Time::getHighResolutionTicks();
+
+    for (int group = 0; group < numChannelGroups; ++group)
+    {
+        const auto& settings = groupSettings[(size_t) group];
+        const auto useGroupSettings = channelLink == ChannelLink::perGroup && settings.has_value();
+
+        // Linked groups share one design rather than repeating it.
+        if (group > 0 && ! useGroupSettings)
+            coefficients.groups[(size_t) group] = coefficients.groups[0];
+        else
+            coefficients.groups[(size_t) group] = makeChainCoefficients(useGroupSettings ? *settings : chainSettings, sampleRate);
+    }
+
+    // A group with settings of its own keeps the extra bands, but takes its
+    // cuts and first band from them.
+    if (engine == FilterEngine::bandGraph)
+    {
+        const auto graphSettings = parameters.getBandGraphSettings();
+
+        for (int group = 0; group < numChannelGroups; ++group)
+        {
+            const auto& settings = groupSettings[(size_t) group];
+
+            if (group > 0 && ! (channelLink == ChannelLink::perGroup && settings.has_value()))
+            {
+                coefficients.graphs[(size_t) group] = coefficients.graphs[0];
+                continue;
+            }
+
+            auto groupGraph = graphSettings;
+
+            if (channelLink == ChannelLink::perGroup && settings.has_value())
+                applyChainSettings(groupGraph, *settings);
+
+            coefficients.graphs[(size_t) group] = makeBandGraphCoefficients(groupGraph, sampleRate);
+        }
+    }
+
+    if (engine == FilterEngine::biquad && chainKernel.load() == ChainKernel::parallel)
+    {
+        for (int group = 0; group < numChannelGroups; ++group)
+        {
+            if (group > 0 && ! (channelLink == ChannelLink::perGroup && groupSettings[(size_t) group].has_value()))
+                coefficients.parallels[(size_t) group] = coefficients.parallels[0];
+            else
+                coefficients.parallels[(size_t) group] = makeParallelCoefficients(coefficients.groups[(size_t) group]);
+        }
+    }
+
+    performanceCounters.record(PerformanceCounters::Event::chainDesign, designStart, juce::Time::getHighResolutionTicks());
+
+    // The convolver and its first kernels are made here, before the switch
+    // to them is published, or the engine would be silent until the design
+    // thread had caught up. After that it crossfades to new ones as they
+    // arrive.
+    if (engine == FilterEngine::linearPhase)
+    {
+        if (! linearPhase.isPrepared())
+            linearPhase.prepare(getSampleRate(), (int) linearPhaseKernels.size());
+
+        linearPhaseGeneration = coefficients.generation;
+        linearPhase.requestKernels(coefficients.groups.data(), channelLink == ChannelLink::perGroup ? numChannelGroups : 1,
+                                   buildKernelsNow || ! linearPhase.hasKernels());
+    }
+
+    coefficientExchange.getWriteSlot() = coefficients;
+    coefficientExchange.publish();
+
+    latestCoefficients = coefficients;
+    ++coefficientGeneration;
+    coefficientBroadcaster.sendChangeMessage();
+
+    auto tailLength = 0;
 
-    settings.lowCutFreq= apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGaininDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    for (const auto& group : coefficients.groups)
+        tailLength = juce::jmax(tailLength, getDecayLengthInSamples(group, tailDecibels));
 
+    if (engine == FilterEngine::bandGraph)
+    {
+        tailLength = 0;
 
-    return settings;
+        for (const auto& graph : coefficients.graphs)
+            tailLength = juce::jmax(tailLength, getDecayLengthInSamples(graph, tailDecibels));
+    }
+
+    tailLengthSeconds.store(tailLength / sampleRate);
+
+    auto latency = oversamplingLatency[(size_t) oversamplingOrder];
+
+    // The whole kernel has to pass through, however short the IIR's tail.
+    if (engine == FilterEngine::linearPhase)
+    {
+        latency = linearPhase.getLatencyInSamples();
+        tailLengthSeconds.store((latency + linearPhase.getKernelLength() / 2) / sampleRate);
+    }
+
+    if (getLatencySamples() != latency)
+        setLatencySamples(latency);
+
+    releaseUnusedLinearPhase();
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+void NewProjectAudioProcessor::releaseUnusedLinearPhase()
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 
-        chainSettings.peakFreq, chainSettings.peakQuality, 
-        juce::Decibels::decibelsToGain(chainSettings.peakGaininDecibels));
+    const juce::ScopedLock sl(designLock);
+
+    // Every set published since linearPhaseGeneration is for another engine,
+    // so once the audio thread has pulled one of them it won't go back to
+    // the convolver without a new set, which would prepare it again.
+    if (linearPhase.isPrepared() && latestCoefficients.engine != FilterEngine::linearPhase
+        && pulledGeneration.load(std::memory_order_acquire) > linearPhaseGeneration)
+        linearPhase.release();
+}
 
+void NewProjectAudioProcessor::pullCoefficients(bool snap)
+{
+    if (auto* coefficients = coefficientExchange.acquire())
+    {
+        activeLink = coefficients->link;
+
+        // There's nothing to glide from at a different processing rate.
+        if (coefficients->oversamplingOrder != activeOversamplingOrder)
+        {
+            setOversamplingOrder(coefficients->oversamplingOrder);
+            snap = true;
+        }
+
+        // The engine being switched to may hold state from the last time it
+        // was used.
+        if (coefficients->engine != activeEngine)
+        {
+            activeEngine = coefficients->engine;
+
+            for (auto& chain : chains)
+                chain.reset();
+
+            for (auto& svfChain : svfChains)
+                svfChain.reset();
+
+            for (auto& bandGraph : bandGraphs)
+                bandGraph.reset();
+
+            for (auto& parallelChain : parallelChains)
+                parallelChain.reset();
+
+            // The convolver is only prepared while it's the engine in use.
+            if (activeEngine == FilterEngine::linearPhase)
+                linearPhase.reset();
+
+            snap = true;
+        }
+
+        // The convolver crossfades between kernels itself.
+        if (activeEngine == FilterEngine::linearPhase)
+            snap = true;
+
+        for (size_t channel = 0; channel < linearPhaseKernels.size(); ++channel)
+            linearPhaseKernels[channel] = activeLink == ChannelLink::linked ? 0 : (int) channelGroups[channel];
+
+        for (size_t group = 0; group < smoothers.size(); ++group)
+        {
+            if (snap)
+                smoothers[group].reset(coefficients->groups[group]);
+            else
+                smoothers[group].setTarget(coefficients->groups[group]);
+        }
+
+        // How long after the input goes silent the output does, measured at
+        // the host's rate and including the oversampling filters.
+        juce::int64 tailLength = 0;
+
+        if (activeEngine == FilterEngine::bandGraph)
+            for (const auto& graph : coefficients->graphs)
+                tailLength = juce::jmax(tailLength, (juce::int64) getDecayLengthInSamples(graph, tailDecibels));
+        else
+            for (const auto& group : coefficients->groups)
+                tailLength = juce::jmax(tailLength, (juce::int64) getDecayLengthInSamples(group, tailDecibels));
+
+        tailLengthSamples = (tailLength >> coefficients->oversamplingOrder)
+                          + 2 * oversamplingLatency[(size_t) coefficients->oversamplingOrder];
+
+        if (activeEngine == FilterEngine::linearPhase)
+            tailLengthSamples = linearPhase.getLatencyInSamples() + linearPhase.getKernelLength() / 2;
+
+        if (activeEngine == FilterEngine::bandGraph)
+            applyBandGraphs(*coefficients, snap);
+        else
+            applySmoothedCoefficients();
+
+        if (activeEngine == FilterEngine::biquad)
+            applyParallelChains(*coefficients, snap);
+
+        // A jump has nothing to crossfade from.
+        if (snap)
+            fadeRemaining = 0;
+
+        pulledGeneration.store(coefficients->generation, std::memory_order_release);
+    }
 }
 
-void NewProjectAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings) {
-    /*auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), chainSettings.peakFreq, chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGaininDecibels));*/
+void NewProjectAudioProcessor::setOversamplingOrder(int order) noexcept
+{
+    activeOversamplingOrder = order;
+    fadeLength = juce::jmax(1, juce::roundToInt(bandFadeSeconds * getSampleRate() * (1 << order)));
 
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    if (auto* oversampler = oversamplers[(size_t) order].get())
+        oversampler->reset();
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    for (auto& chain : chains)
+        chain.reset();
 
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    for (auto& parallelChain : parallelChains)
+        parallelChain.reset();
+
+    for (auto& smoother : smoothers)
+        smoother.prepare(getSampleRate() * (1 << order), smoothingTimeSeconds);
 }
- void updateCoefficients(Coefficients& old, const Coefficients& replacements) {
-     *old = *replacements;
 
+void NewProjectAudioProcessor::applySmoothedCoefficients(int rampLength) noexcept
+{
+    auto getGroup = [this](size_t channel) { return activeLink == ChannelLink::linked ? mainGroup : channelGroups[channel]; };
+
+    // The linear phase kernels come from the design thread instead, and the
+    // band graphs ramp themselves.
+    if (activeEngine == FilterEngine::linearPhase || activeEngine == FilterEngine::bandGraph)
+        return;
+
+    if (activeEngine == FilterEngine::svf)
+    {
+        for (int group = 0; group < numChannelGroups; ++group)
+        {
+            if (activeLink == ChannelLink::perGroup || group == mainGroup)
+            {
+                const auto& current = smoothers[(size_t) group].getCurrent();
+                svfCoefficients[(size_t) group] = makeSvfChainCoefficients(current.settings, current.sampleRate);
+            }
+        }
+
+        for (size_t channel = 0; channel < svfChains.size(); ++channel)
+        {
+            if (svfChains[channel].getActiveSections() != svfCoefficients[(size_t) getGroup(channel)].activeSections)
+            {
+                startBandFade();
+                break;
+            }
+        }
+
+        for (size_t channel = 0; channel < svfChains.size(); ++channel)
+        {
+            const auto& coefficients = svfCoefficients[(size_t) getGroup(channel)];
+
+            if (rampLength > 0)
+                svfChains[channel].rampTo(coefficients, rampLength);
+            else
+                svfChains[channel].setCoefficients(coefficients);
+        }
+
+        return;
+    }
+
+    for (size_t channel = 0; channel < chains.size(); ++channel)
+    {
+        if (getActiveBands(chains[channel]) != getActiveBands(smoothers[(size_t) getGroup(channel)].getCurrent().settings))
+        {
+            startBandFade();
+            break;
+        }
+    }
+
+    for (size_t channel = 0; channel < chains.size(); ++channel)
+    {
+        applyChainCoefficients(chains[channel], smoothers[(size_t) getGroup(channel)].getCurrent());
+
+        if (activeChainKernel == ChainKernel::timeParallel)
+            makeTimeParallelCascade(timeParallelCascades[channel], chains[channel]);
+    }
 }
- void NewProjectAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings) {
-     auto cutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
 
+void NewProjectAudioProcessor::applyBandGraphs(const BusCoefficients& coefficients, bool snap) noexcept
+{
+    auto getGraph = [&](size_t channel) -> const BandGraphCoefficients&
+    {
+        return coefficients.graphs[(size_t) (activeLink == ChannelLink::linked ? mainGroup : channelGroups[channel])];
+    };
+
+    // Sections coming or going can't be ramped, so crossfade instead.
+    for (size_t channel = 0; channel < bandGraphs.size(); ++channel)
+    {
+        if (! bandGraphs[channel].hasSameSections(getGraph(channel)))
+        {
+            startBandFade();
+            break;
+        }
+    }
+
+    const auto rampLength = snap ? 0 : juce::roundToInt(smoothingTimeSeconds * getSampleRate() * (1 << activeOversamplingOrder));
+
+    for (size_t channel = 0; channel < bandGraphs.size(); ++channel)
+        bandGraphs[channel].rampTo(getGraph(channel), rampLength);
+}
 
-     auto& leftLowCut = leftChain.get<ChainPositions::Lowcut>();
-    
+void NewProjectAudioProcessor::applyParallelChains(const BusCoefficients& coefficients, bool snap) noexcept
+{
+    auto getParallel = [&](size_t channel) -> const ParallelCoefficients&
+    {
+        return coefficients.parallels[(size_t) (activeLink == ChannelLink::linked ? mainGroup : channelGroups[channel])];
+    };
+
+    // A change in the number of sections, or between the parallel form and
+    // the chain, can't be ramped, so crossfade instead. If the chains have
+    // just started one, its copies are from before either changed, so it
+    // covers this change too.
+    const auto fadeStarted = fadeRemaining == fadeLength;
+
+    if (! fadeStarted)
+    {
+        for (size_t channel = 0; channel < parallelChains.size(); ++channel)
+        {
+            if (! parallelChains[channel].hasSameSections(getParallel(channel)))
+            {
+                startBandFade();
+                break;
+            }
+        }
+    }
 
-     auto& rightLowCut = rightChain.get<ChainPositions::Lowcut>();
-     updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
-     updateCutFilter(leftLowCut, cutCoefficients, chainSettings.lowCutSlope);
- }
+    const auto rampLength = snap ? 0 : juce::roundToInt(smoothingTimeSeconds * getSampleRate() * (1 << activeOversamplingOrder));
 
- void NewProjectAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
- {
-     auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    for (size_t channel = 0; channel < parallelChains.size(); ++channel)
+    {
+        const auto& parallel = getParallel(channel);
 
+        // The chain hasn't run while the parallel form has, so it starts
+        // again from silence and the crossfade covers the difference.
+        if (parallelChains[channel].isValid() && ! parallel.valid)
+            chains[channel].reset();
 
-     auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
+        parallelChains[channel].rampTo(parallel, rampLength);
+    }
+}
 
-     auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+bool NewProjectAudioProcessor::isSmoothing() const noexcept
+{
+    if (activeEngine == FilterEngine::bandGraph)
+        return std::any_of(bandGraphs.begin(), bandGraphs.end(), [](const auto& graph) { return graph.isRamping(); });
 
+    if (activeLink == ChannelLink::linked)
+        return smoothers[mainGroup].isSmoothing();
 
-     updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    return std::any_of(smoothers.begin(), smoothers.end(), [](const auto& smoother) { return smoother.isSmoothing(); });
+}
 
-     updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+ChainCoefficients NewProjectAudioProcessor::getLatestCoefficients() const
+{
+    const juce::ScopedLock sl(designLock);
+    return latestCoefficients.groups[mainGroup];
+}
 
+BandGraphCoefficients NewProjectAudioProcessor::getLatestBandGraph() const
+{
+    const juce::ScopedLock sl(designLock);
+    return latestCoefficients.graphs[mainGroup];
+}
 
+bool NewProjectAudioProcessor::isBandGraphActive() const
+{
+    const juce::ScopedLock sl(designLock);
+    return latestCoefficients.engine == FilterEngine::bandGraph;
+}
 
+void NewProjectAudioProcessor::setChannelLink(ChannelLink newLink)
+{
+    {
+        const juce::ScopedLock sl(designLock);
+        channelLink = newLink;
+    }
 
- }
+    cachedParameters.markChanged();
+}
 
- void NewProjectAudioProcessor::updateFilters()
- {
-     auto chainSettings = getChainSettings(apvts);
+void NewProjectAudioProcessor::setChannelGroupSettings(ChannelGroup group, const ChainSettings& settings)
+{
+    jassert(group >= 0 && group < numChannelGroups);
 
-     updateLowCutFilters(chainSettings);
-     updatePeakFilter(chainSettings);
-     updateHighCutFilters(chainSettings);
+    {
+        const juce::ScopedLock sl(designLock);
+        groupSettings[(size_t) group] = settings;
+    }
 
- }
+    cachedParameters.markChanged();
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout 
 
 NewProjectAudioProcessor::createParameterLayout() {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq",
-        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20.f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq",
-        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 20000.f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq", "Peak Freq",
-        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain", "Peak Gain",
-        juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.0f));
-
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality", "Peak Quality",
-        juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
-
-    juce::StringArray stringArray;
-    for (int i = 0; i < 4; ++i) {
-        juce::String str;
-        str << (12 + i * 12);
-        str << "db/Oct*";
-        stringArray.add(str);
-    }
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope"
-        , "LowCut Slope", stringArray, 0));
-
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope"
-        , "HighCut Slope", stringArray, 0));
-
-    return layout;
+    // The ids, ranges and defaults are all in ParameterTable.h, which
+    // CachedParameters resolves against in the same order.
+    return createParameterLayoutFromTable();
 }
 //==============================================================================
 // This creates new instances of the plugin..
@@ -9,93 +9,77 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SnapshotExchange.h"
+#include "FilterChain.h"
+#include "ChainSmoother.h"
+#include "AnalyserFifo.h"
+#include "SvfFilter.h"
+#include "LinearPhaseConvolver.h"
+#include "BandGraph.h"
+#include "PluginState.h"
+#include "PresetBank.h"
+#include "PerformanceCounters.h"
+#include "RealtimeSanitizer.h"
+#include "ParameterTable.h"
+#include "TimeParallelKernel.h"
+#include "ParallelForm.h"
+
+ /** How the channels of a multichannel bus share their coefficients. */
+ enum class ChannelLink
+ {
+     linked,     // every channel uses the plugin's parameters
+     perGroup    // each ChannelGroup may be given its own settings
+ };
+
+ /** Channels are grouped by their role in the layout. Ambisonic and
+     discrete channels without a surround/height/LFE role are all "main".
+ */
+ enum ChannelGroup
+ {
+     mainGroup,
+     lfeGroup,
+     surroundGroup,
+     heightGroup,
+     numChannelGroups
+ };
 
-enum Slope {
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-
-class ChainSettings {
-public:
-    float peakFreq{ 0 }, peakGaininDecibels{ 0 }, peakQuality{ 1.f };
-    float lowCutFreq{ 0 }, highCutFreq{ 0 };
-
-    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
-
-};
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-using Filter = juce::dsp::IIR::Filter<float>;
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-enum ChainPositions {
-    Lowcut,
-    Peak,
-    HighCut
-};
-using Coefficients = Filter::CoefficientsPtr;
-
- void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-
- Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+ ChannelGroup getChannelGroup(juce::AudioChannelSet::ChannelType type);
 
- template<int Index, typename ChainType, typename CoefficientType>
- void update(ChainType& chain, const CoefficientType& coefficients)
+ /** How the biquad engine runs its chains. */
+ enum class ChainKernel
  {
-     updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-     chain.template setBypassed<Index>(false);
- }
-
- template<typename ChainType, typename CoefficientType>
- void updateCutFilter(ChainType& chain, const CoefficientType& coefficients,
-     const Slope& slope) {
-     chain.template setBypassed<0>(true);
-     chain.template setBypassed<1>(true);
-     chain.template setBypassed<2>(true);
-     chain.template setBypassed<3>(true);
-
-     switch (slope)
-     {
-     case Slope_48:
-     {
-         update<3>(chain, coefficients);
-     }
-     case Slope_36:
-     {
-         update<2>(chain, coefficients);
-     }
-     case Slope_24:
-     {
-         update<1>(chain, coefficients);
-     }
-     case Slope_12:
-     {
-         update<0>(chain, coefficients);
-     }
-     }
- }
-
- inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+     fused,          // channels side by side in SIMD lanes, each sample after the last
+     timeParallel,   // each channel on its own, several samples at once; for mono and narrow buses
+     parallel        // each channel's sections side by side as a sum, falling back to fused where that's inaccurate
+ };
+
+ /** The coefficients for every channel group, published as one snapshot.
+     They are designed for the sample rate the chains run at, i.e. the host's
+     rate times 2^oversamplingOrder. The graphs are only designed for the
+     Band Graph engine, and the parallel forms for the biquad engine on the
+     parallel kernel.
+ */
+ struct BusCoefficients
  {
-     return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate
-         , 2 * (chainSettings.lowCutSlope + 1));
+     ChannelLink link{ ChannelLink::linked };
+     int oversamplingOrder{ 0 };
+     FilterEngine engine{ FilterEngine::biquad };
+     int generation{ 0 };    // counts the sets published, from 1
+     std::array<ChainCoefficients, numChannelGroups> groups;
+     std::array<BandGraphCoefficients, numChannelGroups> graphs;
+     std::array<ParallelCoefficients, numChannelGroups> parallels;
+ };
 
- }
- inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
- {
-     return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate,
-         2 * (chainSettings.highCutSlope + 1));
- }
-   
+ static_assert(numChannelGroups <= LinearPhaseConvolver::maxKernels, "Each channel group needs its own kernel");
+ 
 
 
 //==============================================================================
 /**
 */
-class NewProjectAudioProcessor  : public juce::AudioProcessor
+class NewProjectAudioProcessor  : public juce::AudioProcessor,
+                                  public juce::AudioProcessorParameter::Listener,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -134,26 +118,221 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
+    /** Restores the parameters from one of a bank's presets, as
+        setStateInformation() does. Returns false if there's no such preset.
+    */
+    bool loadPreset(const PresetBank& bank, int index);
+    /** The parameters' ids and current values, e.g. for PresetBank::write(). */
+    const ParameterState& getParameterState() const noexcept { return parameterState; }
     //====================   Creating My Own Stuff from Here
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
-private:
-
-   
-    MonoChain leftChain, rightChain;
 
-   
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
+
+    /** The most recently designed coefficients of the main channel group.
+        Message thread only.
+    */
+    ChainCoefficients getLatestCoefficients() const;
+    /** The same for the Band Graph engine, and whether it's the one in use. */
+    BandGraphCoefficients getLatestBandGraph() const;
+    bool isBandGraphActive() const;
+
+    /** Chooses whether all channels follow the parameters, or each channel
+        group uses the settings given to setChannelGroupSettings().
+    */
+    void setChannelLink(ChannelLink newLink);
+    /** Overrides the settings of one channel group in ChannelLink::perGroup
+        mode. Groups that were never given settings follow the parameters.
+    */
+    void setChannelGroupSettings(ChannelGroup group, const ChainSettings& settings);
+    /** Message thread: designs and publishes any parameter changes now,
+        rather than on the next timer tick.
+    */
+    void flushCoefficientChanges();
+    /** Incremented every time a new set of coefficients is published. */
+    int getCoefficientGeneration() const noexcept { return coefficientGeneration.get(); }
+    /** Listeners are called on the message thread after new coefficients
+        have been published, so editors don't need to poll.
+    */
+    void addCoefficientListener(juce::ChangeListener* listener) { coefficientBroadcaster.addChangeListener(listener); }
+    void removeCoefficientListener(juce::ChangeListener* listener) { coefficientBroadcaster.removeChangeListener(listener); }
+
+    /** While parameters are gliding, the coefficients are redesigned every
+        this many samples (e.g. 16 or 32).
+    */
+    void setSmoothingInterval(int numSamples) noexcept { smoothingInterval.set(juce::jmax(1, numSamples)); }
+
+    /** Chooses how the biquad engine runs. Any thread; the audio thread
+        switches at the start of its next block. The parallel kernel runs the
+        cascade until its first design has been published.
+    */
+    void setChainKernel(ChainKernel newKernel) noexcept
+    {
+        chainKernel.store(newKernel);
+        cachedParameters.markChanged();
+    }
+
+    static constexpr double smoothingTimeSeconds = 0.05;
+
+    /** The main bus mixed to mono before and after the EQ, for the editor's
+        analyser. Nothing is pushed unless the analyser has been enabled, so
+        with no editor open the audio thread only checks a flag.
+    */
+    AnalyserFifo& getPreEqFifo() noexcept { return preEqFifo; }
+    AnalyserFifo& getPostEqFifo() noexcept { return postEqFifo; }
+    void setAnalyserEnabled(bool shouldBeEnabled) noexcept { analyserEnabled.set(shouldBeEnabled); }
+
+    static constexpr int analyserFifoSize = 1 << 15;
+
+    /** Timing of this instance's audio callbacks and coefficient designs,
+        for the editor's overlay and for writing traces.
+    */
+    PerformanceCounters& getPerformanceCounters() noexcept { return performanceCounters; }
+
+    /** The "Oversampling" parameter chooses 1x, 2x or 4x, i.e. an order of
+        0 to maxOversamplingOrder.
+    */
+    static constexpr int maxOversamplingOrder = 2;
+
+    /** When a band switches in or out of bypass, the old and new chains are
+        crossfaded over this long.
+    */
+    static constexpr double bandFadeSeconds = 0.01;
+    /** Input quieter than this counts as silence, and the filter tails are
+        taken to have died away once they fall below tailDecibels.
+    */
+    static constexpr float silenceThreshold = 1.0e-7f;
+    static constexpr double tailDecibels = -120.0;
+private:
 
-    
    
-
-
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-
-    void updateFilters();
+    // One chain per channel of the main bus, sized in prepareToPlay.
+    std::vector<MonoChain> chains;
+    std::vector<MonoChain*> chainPointers;
+    std::vector<ChannelGroup> channelGroups;
+    std::vector<float*> channelPointers;
+
+    // The time-parallel kernel's form of each chain, remade whenever the
+    // chain's coefficients are, and the kernel the audio thread is using.
+    std::vector<TimeParallelCascade> timeParallelCascades;
+    ChainKernel activeChainKernel{ ChainKernel::fused };
+    std::atomic<ChainKernel> chainKernel{ ChainKernel::fused };
+
+    // The parallel kernel's form of each chain. It ramps to new coefficients
+    // itself, and where it isn't valid the chain runs instead.
+    std::vector<ParallelChain> parallelChains;
+
+    // The same channels on the SVF engine, used instead of chains when it's
+    // selected. svfCoefficients is audio thread scratch space.
+    std::vector<SvfChain> svfChains;
+    std::array<SvfChainCoefficients, numChannelGroups> svfCoefficients;
+    FilterEngine activeEngine{ FilterEngine::biquad };
+
+    // The linear phase engine, and which of its kernels each channel uses.
+    // The convolver has a thread and megabytes of kernels of its own, so it's
+    // only prepared while its engine is selected. linearPhaseGeneration is
+    // the last set published for it, guarded by designLock, and once the
+    // audio thread has pulled a later one it can't be in use any more.
+    LinearPhaseConvolver linearPhase;
+    std::vector<int> linearPhaseKernels;
+    int linearPhaseGeneration{ 0 };
+    std::atomic<int> pulledGeneration{ 0 };
+
+    // The same channels on the Band Graph engine.
+    std::vector<BandGraph> bandGraphs;
+
+    // Copies of the chains from just before a band was switched in or out,
+    // run alongside the new ones while fadeRemaining counts down.
+    std::vector<MonoChain> fadeChains;
+    std::vector<MonoChain*> fadeChainPointers;
+    std::vector<ParallelChain> fadeParallelChains;
+    std::vector<SvfChain> fadeSvfChains;
+    std::vector<BandGraph> fadeBandGraphs;
+    std::vector<float*> fadePointers;
+    juce::AudioBuffer<float> fadeBuffer;
+    int fadeLength{ 0 }, fadeRemaining{ 0 };
+
+    // Audio thread: how long the input has been silent, and how long after
+    // that the output is too, in samples at the host's rate.
+    juce::int64 silentSamples{ 0 };
+    juce::int64 tailLengthSamples{ 0 };
+    bool processingSkipped{ false };
+
+    std::atomic<double> tailLengthSeconds{ 0 };
+
+    // Audio thread only: ramps towards the last acquired snapshot.
+    std::array<ChainSmoother, numChannelGroups> smoothers;
+    ChannelLink activeLink{ ChannelLink::linked };
+    juce::Atomic<int> smoothingInterval{ 32 };
+
+    // One oversampler per factor, all allocated in prepareToPlay so switching
+    // doesn't allocate. Index 0 (no oversampling) is left empty.
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, maxOversamplingOrder + 1> oversamplers;
+    std::array<int, maxOversamplingOrder + 1> oversamplingLatency{};
+    std::vector<float*> oversampledPointers;
+    int activeOversamplingOrder{ -1 };
+
+    PerformanceCounters performanceCounters;
+
+    juce::Atomic<bool> analyserEnabled{ false };
+    AnalyserFifo preEqFifo{ analyserFifoSize }, postEqFifo{ analyserFifoSize };
+
+    // The parameters' generation when they were last designed; the design
+    // is due whenever cachedParameters has moved on from it.
+    std::atomic<juce::uint32> designedGeneration{ 0 };
+    juce::Atomic<int> coefficientGeneration{ 0 };
+    SnapshotExchange<BusCoefficients> coefficientExchange;
+    BusCoefficients latestCoefficients;
+    juce::CriticalSection designLock;
+    juce::ChangeBroadcaster coefficientBroadcaster;
+
+    // Made after apvts has added every parameter.
+    ParameterState parameterState{ getParameters() };
+    CachedParameters cachedParameters{ apvts };
+
+    // Guarded by designLock.
+    ChannelLink channelLink{ ChannelLink::linked };
+    std::array<std::optional<ChainSettings>, numChannelGroups> groupSettings;
+
+    void timerCallback() override;
+
+    // Any thread: marks the parameters' current generation as designed.
+    // Returns false if it already was, i.e. nothing has changed since.
+    bool claimParameterChanges() noexcept;
+
+    // Designs the current parameters and publishes them to the audio thread.
+    // Linear phase kernels are built before returning if buildKernelsNow is
+    // set or there are none yet, or in the background otherwise.
+    void publishCoefficients(bool buildKernelsNow = false);
+    // Frees the linear phase convolver once the audio thread has switched to
+    // another engine. Takes designLock.
+    void releaseUnusedLinearPhase();
+    // Audio thread: starts gliding towards the newest published coefficients,
+    // if any, or jumps straight to them when snap is true.
+    void pullCoefficients(bool snap = false);
+    // Audio thread: copies each group's current smoothed coefficients to its
+    // chains. The SVF engine glides to them over rampLength samples, if given.
+    void applySmoothedCoefficients(int rampLength = 0) noexcept;
+    // Audio thread: the Band Graph engine ramps its coefficients itself, over
+    // the smoothing time, unless snap is set.
+    void applyBandGraphs(const BusCoefficients& coefficients, bool snap) noexcept;
+    // Audio thread: likewise for the parallel kernel's chains.
+    void applyParallelChains(const BusCoefficients& coefficients, bool snap) noexcept;
+    bool isSmoothing() const noexcept;
+    // Audio thread: switches to the oversampler for the given order and
+    // clears any state that belonged to the old processing rate.
+    void setOversamplingOrder(int order) noexcept;
+    // Audio thread: runs the chains over channels at the processing rate.
+    void processChains(float* const* channels, int numChannels, int numSamples) noexcept;
+    // Audio thread: one pass of the active engine with the current
+    // coefficients, crossfading from the old chains if a band has just changed.
+    void processWithEngine(float* const* channels, int numChannels, int numSamples) noexcept;
+    // Audio thread: starts a crossfade from the chains as they are now.
+    void startBandFade() noexcept;
+    bool isInputSilent(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) const noexcept;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NewProjectAudioProcessor)
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    PluginState.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+juce::uint32 hashParameterID(const juce::String& parameterID) noexcept
+{
+    auto hash = (juce::uint32) 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8) *c) * 16777619u;
+
+    return hash;
+}
+
+bool isCompactState(const void* data, size_t sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= (size_t) compactStateHeaderSize
+        && juce::ByteOrder::littleEndianInt(data) == compactStateMagic;
+}
+
+bool findCompactState(const void* data, size_t sizeInBytes, const void*& compactData, size_t& compactSize) noexcept
+{
+    if (isCompactState(data, sizeInBytes))
+    {
+        compactData = data;
+        compactSize = sizeInBytes;
+        return true;
+    }
+
+    if (data == nullptr || sizeInBytes < (size_t) compactStateFooterSize)
+        return false;
+
+    const auto* footer = static_cast<const char*>(data) + sizeInBytes - compactStateFooterSize;
+    const auto size = (size_t) juce::ByteOrder::littleEndianInt(footer);
+
+    if (juce::ByteOrder::littleEndianInt(footer + 4) != compactStateFooterMagic
+         || size > sizeInBytes - (size_t) compactStateFooterSize)
+        return false;
+
+    const auto* start = footer - size;
+
+    if (! isCompactState(start, size))
+        return false;
+
+    compactData = start;
+    compactSize = size;
+    return true;
+}
+
+//==============================================================================
+ParameterState::ParameterState(const juce::Array<juce::AudioProcessorParameter*>& processorParameters)
+{
+    for (auto* parameter : processorParameters)
+    {
+        // Everything an AudioProcessorValueTreeState makes is ranged.
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        jassert(ranged != nullptr);
+
+        if (ranged != nullptr)
+        {
+            idHashes.push_back(hashParameterID(ranged->paramID));
+            sortedHashes.emplace_back(idHashes.back(), (int) parameters.size());
+            parameters.push_back(ranged);
+        }
+    }
+
+    std::sort(sortedHashes.begin(), sortedHashes.end());
+
+    // Two ids with the same hash would be saved and restored as one; rename one.
+    jassert(std::adjacent_find(sortedHashes.begin(), sortedHashes.end(),
+                               [](const auto& a, const auto& b) { return a.first == b.first; }) == sortedHashes.end());
+}
+
+int ParameterState::indexOf(juce::uint32 idHash) const noexcept
+{
+    auto found = std::lower_bound(sortedHashes.begin(), sortedHashes.end(), std::make_pair(idHash, 0));
+    return found != sortedHashes.end() && found->first == idHash ? found->second : -1;
+}
+
+void ParameterState::write(const juce::ValueTree& state, juce::MemoryBlock& destData) const
+{
+    destData.reset();
+
+    {
+        juce::MemoryOutputStream stream(destData, false);
+        state.writeToStream(stream);
+    }
+
+    const auto treeSize = destData.getSize();
+    const auto numEntries = parameters.size();
+    const auto compactSize = (size_t) compactStateHeaderSize + numEntries * (size_t) compactStateEntrySize;
+    destData.setSize(treeSize + compactSize + (size_t) compactStateFooterSize);
+
+    auto* bytes = static_cast<char*>(destData.getData()) + treeSize;
+    juce::ByteOrder::writeLittleEndianInt(bytes, compactStateMagic);
+    juce::ByteOrder::writeLittleEndianShort(bytes + 4, compactStateVersion);
+    juce::ByteOrder::writeLittleEndianShort(bytes + 6, (juce::uint16) compactStateEntrySize);
+    juce::ByteOrder::writeLittleEndianInt(bytes + 8, (juce::uint32) numEntries);
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        auto* entry = bytes + compactStateHeaderSize + i * compactStateEntrySize;
+        const auto* parameter = parameters[i];
+        const auto value = parameter->convertFrom0to1(parameter->getValue());
+        juce::uint32 valueBits;
+        std::memcpy(&valueBits, &value, sizeof(value));
+
+        juce::ByteOrder::writeLittleEndianInt(entry, idHashes[i]);
+        juce::ByteOrder::writeLittleEndianInt(entry + 4, valueBits);
+    }
+
+    auto* footer = bytes + compactSize;
+    juce::ByteOrder::writeLittleEndianInt(footer, (juce::uint32) compactSize);
+    juce::ByteOrder::writeLittleEndianInt(footer + 4, compactStateFooterMagic);
+}
+
+bool ParameterState::read(const void* data, size_t sizeInBytes, std::vector<float>& normalisedValues) const
+{
+    auto values = getDefaultValues();
+
+    if (! readCompactState(data, sizeInBytes, [&](juce::uint32 idHash, float value) { setPlainValue(values, idHash, value); }))
+    {
+        // The ValueTree that AudioProcessorValueTreeState saves has a PARAM
+        // child holding the id and unnormalised value of each parameter.
+        auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+
+        if (! tree.isValid())
+            return false;
+
+        for (const auto& child : tree)
+            if (child.hasProperty("id") && child.hasProperty("value"))
+                setPlainValue(values, hashParameterID(child.getProperty("id").toString()), (float) child.getProperty("value"));
+    }
+
+    normalisedValues = std::move(values);
+    return true;
+}
+
+void ParameterState::apply(const std::vector<float>& normalisedValues) const
+{
+    jassert(normalisedValues.size() == parameters.size());
+
+    for (size_t i = 0; i < juce::jmin(parameters.size(), normalisedValues.size()); ++i)
+        if (parameters[i]->getValue() != normalisedValues[i])
+            parameters[i]->setValueNotifyingHost(normalisedValues[i]);
+}
+
+std::vector<float> ParameterState::getDefaultValues() const
+{
+    std::vector<float> values;
+    values.reserve(parameters.size());
+
+    for (const auto* parameter : parameters)
+        values.push_back(parameter->getDefaultValue());
+
+    return values;
+}
+
+void ParameterState::setPlainValue(std::vector<float>& normalisedValues, juce::uint32 idHash, float value) const
+{
+    const auto index = indexOf(idHash);
+
+    if (index >= 0)
+    {
+        const auto* parameter = parameters[(size_t) index];
+        normalisedValues[(size_t) index] = parameter->convertTo0to1(value);
+    }
+}
+
+std::vector<float> ParameterState::getPlainValues() const
+{
+    std::vector<float> values;
+
+    for (const auto* parameter : parameters)
+        values.push_back(parameter->convertFrom0to1(parameter->getValue()));
+
+    return values;
+}
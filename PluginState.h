@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    PluginState.h
+
+    The compact binary form of the plugin's state, saved after the ValueTree
+    form that earlier versions read, and reading either of them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    A compact state is a flat table of parameter values rather than a whole
+    ValueTree, so saving and restoring it doesn't build, parse or compare any
+    trees or strings. All fields are little-endian:
+
+        uint32  magic, compactStateMagic
+        uint16  version
+        uint16  entrySize, in bytes
+        uint32  numEntries
+        numEntries entries of entrySize bytes, each starting with
+            uint32  hashParameterID() of the parameter's id
+            float32 the parameter's value, unnormalised as in the ValueTree
+
+    Readers skip whatever follows the first 8 bytes of an entry, and anything
+    after the last one, so later versions can add fields and sections that
+    this one ignores. Entries for parameters a reader doesn't have are
+    skipped too, and parameters without an entry go back to their defaults.
+    Values are stored unnormalised so they survive a range being changed.
+*/
+constexpr juce::uint32 compactStateMagic = 0x73635145;  // "EQcs"
+constexpr juce::uint16 compactStateVersion = 1;
+constexpr int compactStateHeaderSize = 12;
+constexpr int compactStateEntrySize = 8;
+
+/**
+    The plugin's saved state is the ValueTree that AudioProcessorValueTreeState
+    writes, followed by a compact state and then a footer:
+
+        uint32  the compact state's size in bytes
+        uint32  magic, compactStateFooterMagic
+
+    ValueTree::readFromData() stops at the end of the tree, so earlier
+    versions restore from that and never see the rest. Since they only save
+    the tree, a state that has been through one of them has no compact state
+    left to disagree with it.
+*/
+constexpr juce::uint32 compactStateFooterMagic = 0x66635145;   // "EQcf"
+constexpr int compactStateFooterSize = 8;
+
+/** A 32 bit FNV-1a hash of a parameter id's UTF-8 bytes. */
+juce::uint32 hashParameterID(const juce::String& parameterID) noexcept;
+
+/** True if data starts with a compact state header. */
+bool isCompactState(const void* data, size_t sizeInBytes) noexcept;
+
+/** Finds the compact state in data, which can be either one on its own or a
+    saved state that ends with one. Returns false if there isn't one.
+*/
+bool findCompactState(const void* data, size_t sizeInBytes, const void*& compactData, size_t& compactSize) noexcept;
+
+/** Calls visit(idHash, value) for each entry of the compact state that
+    findCompactState() finds. Returns false, having visited nothing, if there
+    isn't one or it's cut short.
+*/
+template <typename Visitor>
+bool readCompactState(const void* data, size_t sizeInBytes, Visitor&& visit)
+{
+    if (! findCompactState(data, sizeInBytes, data, sizeInBytes))
+        return false;
+
+    const auto* bytes = static_cast<const char*>(data);
+    const auto entrySize = (size_t) juce::ByteOrder::littleEndianShort(bytes + 6);
+    const auto numEntries = (size_t) juce::ByteOrder::littleEndianInt(bytes + 8);
+
+    if (entrySize < (size_t) compactStateEntrySize
+         || numEntries > (sizeInBytes - (size_t) compactStateHeaderSize) / entrySize)
+        return false;
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        const auto* entry = bytes + compactStateHeaderSize + i * entrySize;
+        const auto valueBits = juce::ByteOrder::littleEndianInt(entry + 4);
+        float value;
+        std::memcpy(&value, &valueBits, sizeof(value));
+
+        visit(juce::ByteOrder::littleEndianInt(entry), value);
+    }
+
+    return true;
+}
+
+//==============================================================================
+/**
+    Saves and restores a processor's parameters, finding them by the hash of
+    their id. It's made once per processor, after its parameters have all
+    been added, and every lookup after that is a binary search.
+*/
+class ParameterState
+{
+public:
+    explicit ParameterState(const juce::Array<juce::AudioProcessorParameter*>& parameters);
+
+    /** Writes state, which should be the processor's
+        AudioProcessorValueTreeState, then every parameter's current value as
+        a compact state, and the footer that finds it.
+    */
+    void write(const juce::ValueTree& state, juce::MemoryBlock& destData) const;
+
+    /** Fills normalisedValues with one value per parameter, in the
+        processor's order. They come from the compact state if there is one,
+        so only states from earlier versions have their ValueTree parsed.
+        Returns false, leaving normalisedValues alone, if data has neither.
+    */
+    bool read(const void* data, size_t sizeInBytes, std::vector<float>& normalisedValues) const;
+
+    /** Sets every parameter whose value differs from normalisedValues,
+        notifying the host and listeners as a parameter change would.
+    */
+    void apply(const std::vector<float>& normalisedValues) const;
+
+    /** The parameters' defaults, normalised, ready to be overwritten by
+        setPlainValue().
+    */
+    std::vector<float> getDefaultValues() const;
+    /** Sets the entry for the parameter with this id hash, if there is one. */
+    void setPlainValue(std::vector<float>& normalisedValues, juce::uint32 idHash, float value) const;
+
+    /** The id hashes and current unnormalised values, in the processor's order. */
+    const std::vector<juce::uint32>& getIdHashes() const noexcept { return idHashes; }
+    std::vector<float> getPlainValues() const;
+
+private:
+    int indexOf(juce::uint32 idHash) const noexcept;
+
+    std::vector<juce::RangedAudioParameter*> parameters;
+    std::vector<juce::uint32> idHashes;
+    std::vector<std::pair<juce::uint32, int>> sortedHashes;     // hash, index in parameters
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterState)
+};
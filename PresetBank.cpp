@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    // Banks that are open somewhere in the process, by path and modification
+    // time, so a bank that's been rewritten is mapped afresh.
+    struct OpenBanks
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, std::weak_ptr<const PresetBank>> banks;
+    };
+
+    OpenBanks& getOpenBanks()
+    {
+        static OpenBanks openBanks;
+        return openBanks;
+    }
+}
+
+std::shared_ptr<const PresetBank> PresetBank::open(const juce::File& file)
+{
+    const auto key = file.getFullPathName() + "|" + juce::String(file.getLastModificationTime().toMilliseconds());
+    auto& openBanks = getOpenBanks();
+    const juce::ScopedLock sl(openBanks.lock);
+
+    // Only banks that opened are added, so failed opens leave nothing behind.
+    if (auto found = openBanks.banks.find(key); found != openBanks.banks.end())
+        if (auto existing = found->second.lock())
+            return existing;
+
+    std::shared_ptr<PresetBank> bank(new PresetBank());
+    bank->mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+    const auto* data = static_cast<const char*>(bank->mappedFile->getData());
+    const auto size = bank->mappedFile->getSize();
+
+    if (data == nullptr || size < (size_t) headerSize || juce::ByteOrder::littleEndianInt(data) != presetBankMagic)
+        return nullptr;
+
+    bank->nameSize = juce::ByteOrder::littleEndianShort(data + 6);
+    bank->numParameters = (int) juce::ByteOrder::littleEndianInt(data + 8);
+    bank->numPresets = (int) juce::ByteOrder::littleEndianInt(data + 12);
+    bank->recordSize = juce::ByteOrder::littleEndianInt(data + 16);
+
+    // Anything that doesn't fit in the file is a corrupt or truncated bank.
+    if (bank->numParameters < 0 || bank->numPresets < 0)
+        return nullptr;
+
+    const auto tableSize = (size_t) headerSize + 4 * (size_t) bank->numParameters;
+
+    if (bank->recordSize < (size_t) bank->nameSize + 4 * (size_t) bank->numParameters
+         || tableSize > size
+         || (bank->recordSize > 0 && (size_t) bank->numPresets > (size - tableSize) / bank->recordSize))
+        return nullptr;
+
+    bank->idHashes = data + headerSize;
+    bank->records = bank->idHashes + 4 * (size_t) bank->numParameters;
+
+    openBanks.banks[key] = bank;
+
+    // Drop entries whose banks have since been closed.
+    for (auto it = openBanks.banks.begin(); it != openBanks.banks.end();)
+        it = it->second.expired() ? openBanks.banks.erase(it) : std::next(it);
+
+    return bank;
+}
+
+bool PresetBank::write(const juce::File& file, const std::vector<juce::uint32>& idHashes,
+                       const juce::StringArray& names, const std::vector<std::vector<float>>& presets)
+{
+    if ((size_t) names.size() != presets.size()
+         || std::any_of(presets.begin(), presets.end(), [&](const auto& values) { return values.size() != idHashes.size(); }))
+    {
+        jassertfalse;
+        return false;
+    }
+
+    const auto numParameters = (int) idHashes.size();
+    const auto recordSize = defaultNameSize + 4 * numParameters;
+
+    // Written next to the file and moved over it, so instances that have the
+    // old bank mapped never see it half written.
+    juce::TemporaryFile temporary(file);
+
+    {
+        juce::FileOutputStream out(temporary.getFile());
+
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt((int) presetBankMagic);
+        out.writeShort((short) presetBankVersion);
+        out.writeShort((short) defaultNameSize);
+        out.writeInt(numParameters);
+        out.writeInt((int) presets.size());
+        out.writeInt(recordSize);
+
+        for (auto idHash : idHashes)
+            out.writeInt((int) idHash);
+
+        for (size_t i = 0; i < presets.size(); ++i)
+        {
+            char name[defaultNameSize]{};
+            names[(int) i].copyToUTF8(name, defaultNameSize);
+            out.write(name, defaultNameSize);
+
+            for (auto value : presets[i])
+                out.writeFloat(value);
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+juce::String PresetBank::getPresetName(int index) const
+{
+    jassert(index >= 0 && index < numPresets);
+
+    const auto* name = getRecord(index);
+    return juce::String::fromUTF8(name, (int) strnlen(name, (size_t) nameSize));
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    A read-only file of named presets, memory-mapped and shared by every
+    instance in the process that opens it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    The bank is laid out so it can be used straight from the mapping, with
+    nothing parsed or copied when it's opened. All fields are little-endian:
+
+        uint32  magic, presetBankMagic
+        uint16  version
+        uint16  nameSize, in bytes
+        uint32  numParameters
+        uint32  numPresets
+        uint32  recordSize, in bytes
+        uint32  idHashes[numParameters], as hashParameterID()
+        numPresets records of recordSize bytes, each starting with
+            char    name[nameSize], UTF-8 padded with zeros
+            float32 values[numParameters], unnormalised, in idHashes' order
+
+    As with a compact state, readers ignore the rest of a record, so a later
+    version can add to it, and a preset is applied by id so the bank needn't
+    list the parameters in the processor's order or have all of them.
+
+    Every instance that opens the same file gets the same mapping, and the
+    pages themselves are shared with any other process that maps it, so a
+    session full of instances only holds the bank in memory once.
+*/
+class PresetBank
+{
+public:
+    /** Maps the bank in file, or returns the one that's already mapped if
+        another instance has it open. Returns nullptr if the file can't be
+        mapped or isn't a bank.
+    */
+    static std::shared_ptr<const PresetBank> open(const juce::File& file);
+
+    /** Writes a bank, with presets[i] holding a value for each of idHashes. */
+    static bool write(const juce::File& file, const std::vector<juce::uint32>& idHashes,
+                      const juce::StringArray& names, const std::vector<std::vector<float>>& presets);
+
+    int getNumPresets() const noexcept { return numPresets; }
+    int getNumParameters() const noexcept { return numParameters; }
+    juce::String getPresetName(int index) const;
+
+    /** Calls visit(idHash, value) for each parameter of the preset. */
+    template <typename Visitor>
+    void visitPreset(int index, Visitor&& visit) const
+    {
+        jassert(index >= 0 && index < numPresets);
+
+        const auto* values = getRecord(index) + nameSize;
+
+        for (int i = 0; i < numParameters; ++i)
+        {
+            const auto valueBits = juce::ByteOrder::littleEndianInt(values + 4 * i);
+            float value;
+            std::memcpy(&value, &valueBits, sizeof(value));
+
+            visit(juce::ByteOrder::littleEndianInt(idHashes + 4 * i), value);
+        }
+    }
+
+    static constexpr juce::uint32 presetBankMagic = 0x62705145;    // "EQpb"
+    static constexpr juce::uint16 presetBankVersion = 1;
+    static constexpr int headerSize = 20;
+    static constexpr int defaultNameSize = 32;
+
+private:
+    PresetBank() = default;
+
+    const char* getRecord(int index) const noexcept { return records + (size_t) index * recordSize; }
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const char* idHashes{ nullptr };
+    const char* records{ nullptr };
+    int numParameters{ 0 }, numPresets{ 0 }, nameSize{ 0 };
+    size_t recordSize{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs NewProjectAudioProcessor through automation scenarios with the
+    realtime sanitizer watching processBlock, and fails if the audio thread
+    allocates, locks or blocks in any of them.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../RealtimeSanitizer.h"
+
+static_assert(RealtimeSanitizer::isCompiledIn(), "Build the realtime safety tests with EQ_REALTIME_SANITIZER=1");
+
+namespace
+{
+    constexpr int blockSize = 256, numBlocks = 600;
+    constexpr double sampleRate = 48000.0;
+
+    using Automation = std::function<void(NewProjectAudioProcessor&, juce::AudioBuffer<float>&, int)>;
+
+    void set(NewProjectAudioProcessor& p, const char* parameterID, float normalisedValue)
+    {
+        p.apvts.getParameter(parameterID)->setValueNotifyingHost(normalisedValue);
+    }
+
+    void fillWithNoise(juce::AudioBuffer<float>& buffer)
+    {
+        juce::Random random(1);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+    }
+
+    // The parameters change between blocks and are designed on this thread,
+    // as the timer would, so only the audio thread's own work is checked.
+    juce::uint64 runScenario(const Automation& automation, const juce::AudioBuffer<float>& noise)
+    {
+        NewProjectAudioProcessor processor;
+        processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        processor.setNonRealtime(false);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        const auto violationsBefore = RealtimeSanitizer::getNumViolations();
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+                buffer.copyFrom(channel, 0, noise, channel, (block % 16) * blockSize, blockSize);
+
+            automation(processor, buffer, block);
+            processor.flushCoefficientChanges();
+            processor.processBlock(buffer, midi);
+        }
+
+        const auto violations = RealtimeSanitizer::getNumViolations() - violationsBefore;
+        processor.releaseResources();
+        return violations;
+    }
+
+    // Makes sure the interceptors are really in the binary, so a clean run
+    // means something.
+    bool sanitizerCatchesAllocation()
+    {
+        const auto violationsBefore = RealtimeSanitizer::getNumViolations();
+
+        {
+            const RealtimeSanitizer::ScopedRealtime realtime;
+            auto* volatile allocation = new int(0);
+            delete allocation;
+        }
+
+        const auto caught = RealtimeSanitizer::getNumViolations() > violationsBefore;
+        RealtimeSanitizer::resetNumViolations();
+        return caught;
+    }
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Report rather than abort, so one run lists every scenario that fails.
+    RealtimeSanitizer::setMode(RealtimeSanitizer::Mode::report);
+
+    if (! sanitizerCatchesAllocation())
+    {
+        std::cerr << "The realtime sanitizer didn't catch an allocation; its interceptors aren't linked in" << std::endl;
+        return 1;
+    }
+
+    const std::pair<const char*, Automation> scenarios[] = {
+        { "peakSweep", [](auto& p, auto&, int block)
+        {
+            set(p, "Peak Freq", (float) (block % 200) / 200.f);
+            set(p, "Peak Gain", 0.5f + 0.4f * std::sin((float) block * 0.05f));
+        } },
+        { "cutSlopes", [](auto& p, auto&, int block)
+        {
+            if (block % 20 == 0)
+            {
+                set(p, "LowCut Freq", 0.1f + 0.01f * (float) (block % 7));
+                set(p, "HighCut Freq", 0.9f);
+                set(p, "LowCut Slope", (float) ((block / 20) % 4) / 3.f);
+            }
+        } },
+        { "bandBypass", [](auto& p, auto&, int block)
+        {
+            if (block % 25 == 0)
+                set(p, "Peak Gain", (block / 25) % 2 == 0 ? 0.5f : 0.75f);
+        } },
+        { "engines", [](auto& p, auto&, int block)
+        {
+            if (block % 50 == 0)
+                set(p, "Filter Engine", (float) ((block / 50) % 4) / 3.f);
+
+            set(p, "Peak Gain", 0.5f + 0.25f * std::sin((float) block * 0.1f));
+        } },
+        { "oversampling", [](auto& p, auto&, int block)
+        {
+            if (block % 40 == 0)
+                set(p, "Oversampling", (float) ((block / 40) % 3) / 2.f);
+
+            set(p, "Peak Freq", (float) (block % 100) / 100.f);
+        } },
+        { "bandGraph", [](auto& p, auto&, int block)
+        {
+            if (block == 0)
+            {
+                set(p, "Filter Engine", 1.f);
+                set(p, "LowCut Freq", 0.2f);
+                set(p, "Graph LowCut Slope", 1.f);
+            }
+
+            if (block % 10 == 0)
+            {
+                const auto prefix = "Band " + juce::String(2 + (block / 10) % (maxGraphBands - 1)) + " ";
+                set(p, (prefix + "Type").toRawUTF8(), (float) ((block / 10) % 4) / 3.f);
+                set(p, (prefix + "Gain").toRawUTF8(), 0.7f);
+            }
+        } },
+        { "silence", [](auto& p, auto& buffer, int block)
+        {
+            if (block > 100 && block < 400)
+                buffer.clear();
+
+            set(p, "Peak Gain", 0.6f);
+        } },
+    };
+
+    juce::AudioBuffer<float> noise(2, blockSize * 16);
+    fillWithNoise(noise);
+
+    int numFailed = 0;
+
+    for (const auto& scenario : scenarios)
+    {
+        const auto violations = runScenario(scenario.second, noise);
+
+        if (violations > 0)
+            ++numFailed;
+
+        std::cout << scenario.first << ": " << (violations > 0 ? juce::String(violations) + " realtime violations" : juce::String("ok")) << std::endl;
+    }
+
+    if (numFailed > 0)
+    {
+        std::cerr << numFailed << " of " << (int) std::size(scenarios) << " scenarios failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+    RealtimeSanitizer.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSanitizer.h"
+
+#if EQ_REALTIME_SANITIZER
+ #if JUCE_LINUX || JUCE_MAC
+  #include <execinfo.h>
+ #endif
+
+ #if JUCE_LINUX
+  #include <dlfcn.h>
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <unistd.h>
+
+  // The TLS model matters: the default one can allocate on a thread's first
+  // access, from inside malloc.
+  #define EQ_SANITIZER_THREAD_LOCAL thread_local __attribute__((tls_model("initial-exec")))
+ #else
+  #define EQ_SANITIZER_THREAD_LOCAL thread_local
+ #endif
+#endif
+
+namespace
+{
+    std::atomic<int> currentMode{ -1 };     // -1 until read from the environment
+    std::atomic<juce::uint64> numViolations{ 0 };
+
+   #if EQ_REALTIME_SANITIZER
+    EQ_SANITIZER_THREAD_LOCAL int realtimeDepth = 0;
+    EQ_SANITIZER_THREAD_LOCAL bool reporting = false;
+   #endif
+
+    RealtimeSanitizer::Mode getModeFromEnvironment() noexcept
+    {
+        // getenv() doesn't allocate, so this is safe from inside malloc.
+        const auto* value = std::getenv("EQ_RTSAN");
+
+        if (value != nullptr && std::strcmp(value, "off") == 0)
+            return RealtimeSanitizer::Mode::off;
+
+        if (value != nullptr && std::strcmp(value, "fatal") == 0)
+            return RealtimeSanitizer::Mode::fatal;
+
+        return RealtimeSanitizer::Mode::report;
+    }
+}
+
+void RealtimeSanitizer::setMode(Mode newMode) noexcept
+{
+    currentMode.store((int) newMode, std::memory_order_relaxed);
+}
+
+RealtimeSanitizer::Mode RealtimeSanitizer::getMode() noexcept
+{
+    auto mode = currentMode.load(std::memory_order_relaxed);
+
+    if (mode < 0)
+    {
+        mode = (int) getModeFromEnvironment();
+        currentMode.store(mode, std::memory_order_relaxed);
+    }
+
+    return static_cast<Mode>(mode);
+}
+
+juce::uint64 RealtimeSanitizer::getNumViolations() noexcept
+{
+    return numViolations.load(std::memory_order_relaxed);
+}
+
+void RealtimeSanitizer::resetNumViolations() noexcept
+{
+    numViolations.store(0, std::memory_order_relaxed);
+}
+
+#if EQ_REALTIME_SANITIZER
+RealtimeSanitizer::ScopedRealtime::ScopedRealtime(bool shouldCheck) noexcept
+    : checking(shouldCheck)
+{
+    if (checking)
+        ++realtimeDepth;
+}
+
+RealtimeSanitizer::ScopedRealtime::~ScopedRealtime()
+{
+    if (checking)
+        --realtimeDepth;
+}
+#endif
+
+void RealtimeSanitizer::check(const char* operation) noexcept
+{
+   #if EQ_REALTIME_SANITIZER
+    if (realtimeDepth == 0 || reporting)
+        return;
+
+    const auto mode = getMode();
+
+    if (mode == Mode::off)
+        return;
+
+    numViolations.fetch_add(1, std::memory_order_relaxed);
+
+    // Whatever the report itself does isn't checked.
+    reporting = true;
+
+    std::fputs("Realtime violation: ", stderr);
+    std::fputs(operation, stderr);
+    std::fputs(" on the audio thread\n", stderr);
+
+   #if JUCE_LINUX || JUCE_MAC
+    void* frames[64];
+    backtrace_symbols_fd(frames, backtrace(frames, 64), fileno(stderr));
+   #endif
+
+    std::fflush(stderr);
+
+    if (mode == Mode::fatal)
+        std::abort();
+
+    reporting = false;
+   #else
+    juce::ignoreUnused(operation);
+   #endif
+}
+
+//==============================================================================
+#if EQ_REALTIME_SANITIZER
+
+ #if JUCE_LINUX
+// glibc's own entry points to its allocator, so the allocation functions
+// below can pass calls on without calling themselves.
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+ #endif
+
+namespace
+{
+    void* allocate(size_t size, const char* operation) noexcept
+    {
+        RealtimeSanitizer::check(operation);
+
+       #if JUCE_LINUX
+        return __libc_malloc(size == 0 ? 1 : size);
+       #else
+        return std::malloc(size == 0 ? 1 : size);
+       #endif
+    }
+
+    void deallocate(void* p, const char* operation) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        RealtimeSanitizer::check(operation);
+
+       #if JUCE_LINUX
+        __libc_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+}
+
+void* operator new(size_t size)
+{
+    if (auto* p = allocate(size, "operator new"))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (auto* p = allocate(size, "operator new[]"))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept     { return allocate(size, "operator new"); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept   { return allocate(size, "operator new[]"); }
+void operator delete(void* p) noexcept                              { deallocate(p, "operator delete"); }
+void operator delete[](void* p) noexcept                            { deallocate(p, "operator delete[]"); }
+void operator delete(void* p, size_t) noexcept                      { deallocate(p, "operator delete"); }
+void operator delete[](void* p, size_t) noexcept                    { deallocate(p, "operator delete[]"); }
+
+// The aligned forms are left to the standard library, which implements
+// them with the aligned allocation functions intercepted below on Linux.
+
+ #if JUCE_LINUX
+namespace
+{
+    // The next definition in the search order, i.e. libc's, looked up on
+    // first use. These are constant initialised, so they work even for calls
+    // made before static constructors have run.
+    struct NextFunction
+    {
+        const char* name;
+        std::atomic<void*> pointer{ nullptr };
+
+        template <typename Function>
+        Function* get() noexcept
+        {
+            auto* p = pointer.load(std::memory_order_relaxed);
+
+            if (p == nullptr)
+            {
+                p = dlsym(RTLD_NEXT, name);
+                pointer.store(p, std::memory_order_relaxed);
+            }
+
+            return reinterpret_cast<Function*>(p);
+        }
+    };
+
+    NextFunction nextMutexLock{ "pthread_mutex_lock" }, nextConditionWait{ "pthread_cond_wait" },
+                 nextConditionTimedWait{ "pthread_cond_timedwait" }, nextNanosleep{ "nanosleep" }, nextUsleep{ "usleep" },
+                 nextRead{ "read" }, nextWrite{ "write" }, nextOpen{ "open" };
+}
+
+// Calls from the executable come to these rather than libc's.
+extern "C"
+{
+    void* malloc(size_t size) __THROW
+    {
+        RealtimeSanitizer::check("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) __THROW
+    {
+        RealtimeSanitizer::check("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size) __THROW
+    {
+        RealtimeSanitizer::check("realloc");
+        return __libc_realloc(p, size);
+    }
+
+    void free(void* p) __THROW
+    {
+        if (p != nullptr)
+            RealtimeSanitizer::check("free");
+
+        __libc_free(p);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) __THROW
+    {
+        RealtimeSanitizer::check("posix_memalign");
+
+        if (auto* p = __libc_memalign(alignment, size))
+        {
+            *result = p;
+            return 0;
+        }
+
+        return ENOMEM;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) __THROW
+    {
+        RealtimeSanitizer::check("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL
+    {
+        RealtimeSanitizer::check("pthread_mutex_lock");
+        return nextMutexLock.get<int(pthread_mutex_t*)>()(mutex);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        RealtimeSanitizer::check("pthread_cond_wait");
+        return nextConditionWait.get<int(pthread_cond_t*, pthread_mutex_t*)>()(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        RealtimeSanitizer::check("pthread_cond_timedwait");
+        return nextConditionTimedWait.get<int(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)>()(condition, mutex, time);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        RealtimeSanitizer::check("nanosleep");
+        return nextNanosleep.get<int(const struct timespec*, struct timespec*)>()(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        RealtimeSanitizer::check("usleep");
+        return nextUsleep.get<int(useconds_t)>()(microseconds);
+    }
+
+    ssize_t read(int fd, void* buffer, size_t size)
+    {
+        RealtimeSanitizer::check("read");
+        return nextRead.get<ssize_t(int, void*, size_t)>()(fd, buffer, size);
+    }
+
+    ssize_t write(int fd, const void* buffer, size_t size)
+    {
+        RealtimeSanitizer::check("write");
+        return nextWrite.get<ssize_t(int, const void*, size_t)>()(fd, buffer, size);
+    }
+
+    int open(const char* path, int flags, ...)
+    {
+        RealtimeSanitizer::check("open");
+
+        mode_t mode = 0;
+
+        if ((flags & O_CREAT) != 0)
+        {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+
+        return nextOpen.get<int(const char*, int, ...)>()(path, flags, mode);
+    }
+}
+ #endif
+#endif
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    RealtimeSanitizer.h
+
+    A debug build mode that catches the audio thread allocating, locking or
+    making blocking system calls.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Set to 1 in a debug or test build to compile the checks in. With it left
+    at 0, ScopedRealtime is empty and nothing is intercepted.
+*/
+#ifndef EQ_REALTIME_SANITIZER
+ #define EQ_REALTIME_SANITIZER 0
+#endif
+
+/**
+    While a ScopedRealtime is alive on a thread, anything that can block on
+    that thread is a violation: global operator new and delete everywhere,
+    and on Linux also malloc and friends, pthread mutex and condition waits,
+    sleeps, and file reads, writes and opens. Each violation is counted, and
+    either reported on stderr with a stack trace or made fatal, depending on
+    the mode.
+
+    The mode starts as whatever the EQ_RTSAN environment variable says
+    ("off", "report" or "fatal"), or report if it isn't set.
+
+    Violations are only looked for, not prevented, so a run in report mode
+    carries on and finds all of them. Other platforms only get the operator
+    new and delete checks, which still catch most of what matters.
+*/
+class RealtimeSanitizer
+{
+public:
+    enum class Mode
+    {
+        off,
+        report,
+        fatal
+    };
+
+    static constexpr bool isCompiledIn() noexcept { return EQ_REALTIME_SANITIZER != 0; }
+
+    static void setMode(Mode newMode) noexcept;
+    static Mode getMode() noexcept;
+
+    /** Violations so far, on any thread. */
+    static juce::uint64 getNumViolations() noexcept;
+    static void resetNumViolations() noexcept;
+
+    /** Marks the calling thread as realtime for the enclosing scope, unless
+        shouldCheck is false. Scopes nest.
+    */
+    class ScopedRealtime
+    {
+    public:
+       #if EQ_REALTIME_SANITIZER
+        explicit ScopedRealtime(bool shouldCheck = true) noexcept;
+        ~ScopedRealtime();
+
+    private:
+        const bool checking;
+       #else
+        explicit ScopedRealtime(bool = true) noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+    };
+
+    /** Called by the interceptors. Counts and reports a violation if the
+        calling thread is in a realtime scope.
+    */
+    static void check(const char* operation) noexcept;
+};
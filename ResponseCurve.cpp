@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+
+namespace
+{
+    bool sameSections(const BiquadCoefficients* a, const BiquadCoefficients* b, int numSections) noexcept
+    {
+        for (int i = 0; i < numSections; ++i)
+        {
+            if (a[i].b0 != b[i].b0 || a[i].b1 != b[i].b1 || a[i].b2 != b[i].b2
+                || a[i].a1 != b[i].a1 || a[i].a2 != b[i].a2)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool sameCut(const CutCoefficients& a, const CutCoefficients& b) noexcept
+    {
+        return a.numStages == b.numStages && sameSections(a.stages.data(), b.stages.data(), a.numStages);
+    }
+
+    // dest = c0 + c1 * x + c2 * xSquared
+    void evaluateQuadratic(float* dest, const float* x, const float* xSquared, double c0, double c1, double c2, int num) noexcept
+    {
+        juce::FloatVectorOperations::copyWithMultiply(dest, x, (float) c1, num);
+        juce::FloatVectorOperations::addWithMultiply(dest, xSquared, (float) c2, num);
+        juce::FloatVectorOperations::add(dest, (float) c0, num);
+    }
+}
+
+void ResponseCurve::setFrequencies(int numPoints, double minFrequency, double maxFrequency)
+{
+    jassert(minFrequency > 0 && maxFrequency > minFrequency);
+
+    const auto size = (size_t) juce::jmax(0, numPoints);
+    std::vector<float> newFrequencies(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        const auto proportion = size > 1 ? (double) i / (double) (size - 1) : 0.0;
+        newFrequencies[i] = (float) (minFrequency * std::pow(maxFrequency / minFrequency, proportion));
+    }
+
+    setFrequencies(std::move(newFrequencies));
+}
+
+void ResponseCurve::setFrequencies(std::vector<float> newFrequencies)
+{
+    frequencies = std::move(newFrequencies);
+    const auto size = frequencies.size();
+
+    for (auto* array : { &phi, &phiSquared, &numerator, &denominator, &decibels })
+        array->resize(size);
+
+    for (auto& magnitudes : bandMagnitudes)
+        magnitudes.resize(size);
+
+    phaseSampleRate = 0;
+    cacheValid = false;
+}
+
+void ResponseCurve::updatePhase(double sampleRate)
+{
+    for (size_t i = 0; i < frequencies.size(); ++i)
+    {
+        const auto s = std::sin(juce::MathConstants<double>::pi * frequencies[i] / sampleRate);
+        phi[i] = (float) (s * s);
+    }
+
+    juce::FloatVectorOperations::multiply(phiSquared.data(), phi.data(), phi.data(), getNumPoints());
+    phaseSampleRate = sampleRate;
+}
+
+void ResponseCurve::computeBand(ChainPositions band, const BiquadCoefficients* sections, int numSections)
+{
+    const auto num = getNumPoints();
+    auto* magnitudes = bandMagnitudes[(size_t) band].data();
+
+    juce::FloatVectorOperations::fill(magnitudes, 1.0f, num);
+
+    for (int i = 0; i < numSections; ++i)
+    {
+        const double b0 = sections[i].b0, b1 = sections[i].b1, b2 = sections[i].b2;
+        const double a1 = sections[i].a1, a2 = sections[i].a2;
+
+        evaluateQuadratic(numerator.data(), phi.data(), phiSquared.data(),
+                          (b0 + b1 + b2) * (b0 + b1 + b2), -4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2), 16.0 * b0 * b2, num);
+        evaluateQuadratic(denominator.data(), phi.data(), phiSquared.data(),
+                          (1.0 + a1 + a2) * (1.0 + a1 + a2), -4.0 * (a1 + 4.0 * a2 + a1 * a2), 16.0 * a2, num);
+
+        juce::FloatVectorOperations::multiply(magnitudes, numerator.data(), num);
+
+        for (int j = 0; j < num; ++j)
+            magnitudes[j] /= denominator[j];
+    }
+}
+
+bool ResponseCurve::update(const ChainCoefficients& coefficients)
+{
+    if (coefficients.sampleRate <= 0 || frequencies.empty())
+        return false;
+
+    if (coefficients.sampleRate != phaseSampleRate)
+    {
+        updatePhase(coefficients.sampleRate);
+        cacheValid = false;
+    }
+
+    auto changed = ! cacheValid;
+
+    // Bands the processor bypasses are drawn flat, as they sound.
+    const auto bands = getActiveBands(coefficients.settings);
+    const auto bandsChanged = ! cacheValid || bands != getActiveBands(cached.settings);
+    auto isActive = [bands](ChainPositions band) { return (bands & (1 << band)) != 0; };
+
+    if (bandsChanged || ! sameCut(cached.lowCut, coefficients.lowCut))
+    {
+        computeBand(Lowcut, coefficients.lowCut.stages.data(), isActive(Lowcut) ? coefficients.lowCut.numStages : 0);
+        changed = true;
+    }
+
+    if (bandsChanged || ! sameSections(&cached.peak, &coefficients.peak, 1))
+    {
+        computeBand(Peak, &coefficients.peak, isActive(Peak) ? 1 : 0);
+        changed = true;
+    }
+
+    if (bandsChanged || ! sameCut(cached.highCut, coefficients.highCut))
+    {
+        computeBand(HighCut, coefficients.highCut.stages.data(), isActive(HighCut) ? coefficients.highCut.numStages : 0);
+        changed = true;
+    }
+
+    cached = coefficients;
+    cacheValid = true;
+
+    if (! changed)
+        return false;
+
+    const auto num = getNumPoints();
+    auto* total = decibels.data();
+
+    juce::FloatVectorOperations::multiply(total, bandMagnitudes[Lowcut].data(), bandMagnitudes[Peak].data(), num);
+    juce::FloatVectorOperations::multiply(total, bandMagnitudes[HighCut].data(), num);
+    convertToDecibels();
+
+    return true;
+}
+
+bool ResponseCurve::update(const BandGraphCoefficients& coefficients)
+{
+    if (coefficients.sampleRate <= 0 || frequencies.empty())
+        return false;
+
+    if (coefficients.sampleRate != phaseSampleRate)
+        updatePhase(coefficients.sampleRate);
+
+    std::array<BiquadCoefficients, BandGraphCoefficients::maxSections> sections;
+
+    for (int i = 0; i < coefficients.numSections; ++i)
+        sections[(size_t) i] = coefficients.getSection(i);
+
+    // The whole graph goes through one band's storage, which leaves the
+    // per band cache out of date.
+    computeBand(Lowcut, sections.data(), coefficients.numSections);
+    cacheValid = false;
+
+    std::copy(bandMagnitudes[Lowcut].begin(), bandMagnitudes[Lowcut].end(), decibels.begin());
+    convertToDecibels();
+
+    return true;
+}
+
+void ResponseCurve::convertToDecibels() noexcept
+{
+    auto* total = decibels.data();
+
+    // 10 log10 of the squared magnitude; the floor keeps deep stopbands finite.
+    for (int i = 0; i < getNumPoints(); ++i)
+        total[i] = 10.0f * std::log10(juce::jmax(total[i], 1.0e-30f));
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.h
+
+    The chain's magnitude response over a set of display frequencies.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+#include "BandGraph.h"
+
+/**
+    Evaluates the magnitude of every band at all of the display frequencies
+    at once, using vector operations rather than one complex evaluation per
+    filter per pixel.
+
+    Each band's response is cached, and update() only recomputes the bands
+    whose coefficients differ from last time, so dragging the peak doesn't
+    re-evaluate up to eight cut sections that haven't moved.
+
+    For a section with a0 = 1 and phi = sin^2(w / 2), the squared magnitude is
+        ((b0 + b1 + b2)^2 - 4 (b0 b1 + 4 b0 b2 + b1 b2) phi + 16 b0 b2 phi^2)
+      / ((1 + a1 + a2)^2 - 4 (a1 + 4 a2 + a1 a2) phi + 16 a2 phi^2)
+    which stays accurate near DC, unlike the form in cos w.
+*/
+class ResponseCurve
+{
+public:
+    ResponseCurve() = default;
+
+    /** Spaces numPoints frequencies logarithmically from minFrequency to
+        maxFrequency. Everything is recomputed on the next update().
+    */
+    void setFrequencies(int numPoints, double minFrequency, double maxFrequency);
+    /** Uses the given frequencies, in Hz, e.g. the bins of an FFT. */
+    void setFrequencies(std::vector<float> newFrequencies);
+
+    /** Brings the response up to date with the given coefficients.
+        Returns false if nothing changed.
+    */
+    bool update(const ChainCoefficients& coefficients);
+    /** The same for a BandGraph's sections. Always recomputes everything. */
+    bool update(const BandGraphCoefficients& coefficients);
+
+    int getNumPoints() const noexcept { return (int) frequencies.size(); }
+    const float* getFrequencies() const noexcept { return frequencies.data(); }
+
+    /** The response of the whole chain at each frequency, in decibels. */
+    const float* getMagnitudesInDecibels() const noexcept { return decibels.data(); }
+
+private:
+    static constexpr int numBands = 3;
+
+    void updatePhase(double sampleRate);
+    void computeBand(ChainPositions band, const BiquadCoefficients* sections, int numSections);
+    void convertToDecibels() noexcept;
+
+    std::vector<float> frequencies, phi, phiSquared;
+    std::vector<float> numerator, denominator;
+    std::array<std::vector<float>, numBands> bandMagnitudes;    // squared, per ChainPositions
+    std::vector<float> decibels;
+
+    ChainCoefficients cached;
+    double phaseSampleRate{ 0 };
+    bool cacheValid{ false };
+};
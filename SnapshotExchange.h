@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    SnapshotExchange.h
+
+    Wait-free handoff of an immutable value from one producer thread to one
+    consumer thread (a triple buffer).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    The producer fills the slot returned by getWriteSlot() and calls publish();
+    the consumer calls acquire() to pick up the most recent published value.
+    Neither side ever blocks, allocates or waits for the other, and a slot is
+    never written while the consumer is reading it.
+
+    Only one thread may act as producer and one as consumer at any time.
+*/
+template <typename ValueType>
+class SnapshotExchange
+{
+public:
+    SnapshotExchange() = default;
+
+    /** Producer: the slot to fill before calling publish(). */
+    ValueType& getWriteSlot() noexcept { return slots[(size_t) backIndex]; }
+
+    /** Producer: makes the value in the write slot visible to the consumer. */
+    void publish() noexcept
+    {
+        backIndex = middle.exchange (backIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Consumer: returns the newest value if one was published since the last
+        call, or nullptr if nothing has changed.
+    */
+    const ValueType* acquire() noexcept
+    {
+        if ((middle.load (std::memory_order_acquire) & freshFlag) == 0)
+            return nullptr;
+
+        frontIndex = middle.exchange (frontIndex, std::memory_order_acq_rel) & indexMask;
+        return &slots[(size_t) frontIndex];
+    }
+
+    /** Consumer: the value returned by the last successful acquire(). */
+    const ValueType& getCurrent() const noexcept { return slots[(size_t) frontIndex]; }
+
+private:
+    static constexpr int indexMask = 3, freshFlag = 4;
+
+    std::array<ValueType, 3> slots;
+    int backIndex = 0, frontIndex = 1;
+    std::atomic<int> middle { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE (SnapshotExchange)
+};
@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::SpectrumAnalyser(std::vector<AnalyserFifo*> fifos)
+    : juce::Thread("Spectrum Analyser")
+{
+    for (auto* fifo : fifos)
+    {
+        auto source = std::make_unique<Source>();
+        source->fifo = fifo;
+        sources.push_back(std::move(source));
+    }
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stop();
+}
+
+void SpectrumAnalyser::start(const Options& newOptions)
+{
+    stop();
+
+    options = newOptions;
+    options.fftOrder = juce::jlimit(8, 15, options.fftOrder);
+    options.overlap = juce::jlimit(1, 1 << options.fftOrder, options.overlap);
+    options.averaging = juce::jlimit(0.0f, 0.99f, options.averaging);
+    options.numBins = juce::jlimit(2, maxNumBins, options.numBins);
+
+    prepareSources();
+    bandSampleRate = 0;
+    startThread();
+}
+
+void SpectrumAnalyser::stop()
+{
+    stopThread(1000);
+}
+
+void SpectrumAnalyser::prepareSources()
+{
+    const auto fftSize = 1 << options.fftOrder;
+
+    fft = std::make_unique<juce::dsp::FFT>(options.fftOrder);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t) fftSize,
+                                                                  juce::dsp::WindowingFunction<float>::hann,
+                                                                  false);
+
+    for (auto& source : sources)
+    {
+        source->history.assign((size_t) fftSize, 0.0f);
+        source->fftData.assign((size_t) fftSize * 2, 0.0f);
+        source->power.assign((size_t) fftSize / 2 + 1, 0.0f);
+        source->numPending = 0;
+        source->hasNewFrame = false;
+
+        // Whatever was queued before we started is stale.
+        source->fifo->discard();
+    }
+}
+
+void SpectrumAnalyser::prepareBands(double newSampleRate)
+{
+    const auto fftSize = 1 << options.fftOrder;
+    const auto binWidth = newSampleRate / fftSize;
+    const auto lastBin = fftSize / 2;
+    const auto maxFrequency = juce::jmin(options.maxFrequency, newSampleRate / 2);
+    const auto ratio = maxFrequency / options.minFrequency;
+
+    bands.resize((size_t) options.numBins);
+
+    for (int i = 0; i < options.numBins; ++i)
+    {
+        auto frequencyAt = [&](double proportion)
+        {
+            return options.minFrequency * std::pow(ratio, juce::jlimit(0.0, 1.0, proportion));
+        };
+
+        const auto step = 1.0 / (options.numBins - 1);
+        const auto centre = frequencyAt(i * step);
+        auto& band = bands[(size_t) i];
+
+        band.first = juce::jmin(lastBin, (int) std::ceil(frequencyAt((i - 0.5) * step) / binWidth));
+        band.last = juce::jmin(lastBin, (int) std::floor(frequencyAt((i + 0.5) * step) / binWidth));
+        band.position = (float) juce::jmin((double) lastBin, centre / binWidth);
+    }
+
+    bandSampleRate = newSampleRate;
+    bandMaxFrequency = maxFrequency;
+}
+
+void SpectrumAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        const auto currentSampleRate = sampleRate.load();
+
+        if (currentSampleRate > 0 && currentSampleRate != bandSampleRate)
+            prepareBands(currentSampleRate);
+
+        auto published = false;
+
+        for (auto& source : sources)
+        {
+            if (readSource(*source) && bandSampleRate > 0)
+            {
+                publish(*source);
+                published = true;
+            }
+        }
+
+        if (published)
+            sendChangeMessage();
+
+        wait(10);
+    }
+}
+
+bool SpectrumAnalyser::readSource(Source& source)
+{
+    const auto fftSize = (int) source.history.size();
+    const auto hopSize = fftSize / options.overlap;
+    auto* hop = source.history.data() + fftSize - hopSize;
+
+    for (;;)
+    {
+        if (source.numPending == 0)
+        {
+            if (source.fifo->getNumReady() == 0)
+                break;
+
+            // Slide the window along to make room for the next hop.
+            std::copy(source.history.begin() + hopSize, source.history.end(), source.history.begin());
+        }
+
+        source.numPending += source.fifo->pull(hop + source.numPending, hopSize - source.numPending);
+
+        if (source.numPending < hopSize)
+            break;
+
+        transform(source);
+        source.numPending = 0;
+    }
+
+    return std::exchange(source.hasNewFrame, false);
+}
+
+void SpectrumAnalyser::transform(Source& source)
+{
+    const auto fftSize = (int) source.history.size();
+    auto* data = source.fftData.data();
+
+    std::copy(source.history.begin(), source.history.end(), data);
+    window->multiplyWithWindowingTable(data, (size_t) fftSize);
+    fft->performFrequencyOnlyForwardTransform(data);
+
+    // A full scale sine peaks at fftSize / 4 after the Hann window.
+    const auto scale = 4.0f / (float) fftSize;
+    const auto averaging = options.averaging;
+
+    for (size_t bin = 0; bin < source.power.size(); ++bin)
+    {
+        const auto level = data[bin] * scale;
+        source.power[bin] = averaging * source.power[bin] + (1.0f - averaging) * level * level;
+    }
+
+    source.hasNewFrame = true;
+}
+
+void SpectrumAnalyser::publish(Source& source)
+{
+    auto& spectrum = source.spectra.getWriteSlot();
+    const auto* power = source.power.data();
+    spectrum.numBins = (int) bands.size();
+    spectrum.minFrequency = options.minFrequency;
+    spectrum.maxFrequency = bandMaxFrequency;
+
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        const auto& band = bands[i];
+        float value;
+
+        // Wide bands show their loudest bin so tones don't get averaged away.
+        if (band.last >= band.first)
+        {
+            value = *std::max_element(power + band.first, power + band.last + 1);
+        }
+        else
+        {
+            const auto index = juce::jmin((int) band.position, (int) source.power.size() - 2);
+            const auto fraction = band.position - (float) index;
+            value = power[index] + fraction * (power[index + 1] - power[index]);
+        }
+
+        spectrum.decibels[i] = 10.0f * std::log10(juce::jmax(value, 1.0e-12f));
+    }
+
+    source.spectra.publish();
+}
+
+bool SpectrumAnalyser::getSpectrum(int sourceIndex, Spectrum& result)
+{
+    jassert(juce::isPositiveAndBelow(sourceIndex, (int) sources.size()));
+
+    if (auto* spectrum = sources[(size_t) sourceIndex]->spectra.acquire())
+    {
+        result = *spectrum;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+    Turns the samples queued in AnalyserFifos into log-frequency spectra on
+    a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalyserFifo.h"
+#include "SnapshotExchange.h"
+
+/**
+    Each source is read in hops of fftSize / overlap samples. After every hop
+    the last fftSize samples are Hann windowed and transformed, and the power
+    in each FFT bin is exponentially averaged with the previous frames. Once
+    everything queued has been consumed, the average is reduced to numBins
+    log-spaced bands and published, and a change message is sent.
+
+    Spectra are in decibels relative to a full scale sine. Nothing here runs
+    on the audio thread; the processor only pushes into the FIFOs.
+*/
+class SpectrumAnalyser : public juce::ChangeBroadcaster,
+                         private juce::Thread
+{
+public:
+    struct Options
+    {
+        int fftOrder{ 12 };
+        int overlap{ 4 };           // transforms per fftSize samples
+        float averaging{ 0.7f };    // 0 shows each frame as is, towards 1 averages longer
+        int numBins{ 256 };
+        double minFrequency{ 20.0 }, maxFrequency{ 20000.0 };
+    };
+
+    static constexpr int maxNumBins = 1024;
+
+    /** numBins values, log-spaced from minFrequency to maxFrequency. */
+    struct Spectrum
+    {
+        int numBins{ 0 };
+        double minFrequency{ 0 }, maxFrequency{ 0 };
+        std::array<float, maxNumBins> decibels;
+    };
+
+    explicit SpectrumAnalyser(std::vector<AnalyserFifo*> sources);
+    ~SpectrumAnalyser() override;
+
+    /** Starts, or restarts, the background thread with the given options. */
+    void start(const Options& newOptions);
+    void stop();
+
+    /** May be called from any thread; the bands are rebuilt if it changes. */
+    void setSampleRate(double newSampleRate) noexcept { sampleRate.store(newSampleRate); }
+
+    /** Message thread: copies the newest spectrum of a source into result.
+        Returns false if nothing new has been published since the last call.
+    */
+    bool getSpectrum(int sourceIndex, Spectrum& result);
+
+private:
+    struct Source
+    {
+        AnalyserFifo* fifo;
+        std::vector<float> history, fftData, power;
+        int numPending{ 0 };
+        bool hasNewFrame{ false };
+        SnapshotExchange<Spectrum> spectra;
+    };
+
+    // Each output band covers the FFT bins first to last, or if it's
+    // narrower than a bin, interpolates at position.
+    struct Band
+    {
+        int first{ 0 }, last{ -1 };
+        float position{ 0 };
+    };
+
+    void run() override;
+    void prepareSources();
+    void prepareBands(double newSampleRate);
+    bool readSource(Source& source);
+    void transform(Source& source);
+    void publish(Source& source);
+
+    std::vector<std::unique_ptr<Source>> sources;
+    Options options;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::vector<Band> bands;
+    std::atomic<double> sampleRate{ 0 };
+    double bandSampleRate{ 0 }, bandMaxFrequency{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(SpectrumAnalyser)
+};
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    SvfFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "SvfFilter.h"
+
+namespace
+{
+    double getPrewarpedGain(double frequency, double sampleRate) noexcept
+    {
+        return std::tan(juce::MathConstants<double>::pi * juce::jlimit(2.0, sampleRate * 0.49, frequency) / sampleRate);
+    }
+
+    void addCut(SvfChainCoefficients& result, int firstSection, double g, Slope slope, bool isHighpass) noexcept
+    {
+        const auto numStages = (int) slope + 1;
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            const auto k = getButterworthInverseQ(numStages, i);
+            auto& section = result.sections[(size_t) (firstSection + i)];
+
+            if (isHighpass)
+                section = { (float) g, (float) k, 1.0f, (float) -k, -1.0f };
+            else
+                section = { (float) g, (float) k, 0.0f, 0.0f, 1.0f };
+
+            result.activeSections |= 1 << (firstSection + i);
+        }
+    }
+
+    // Same response as makePeakCoefficients(): the bell's bandwidth is
+    // scaled by the gain so that boosts and cuts are symmetrical.
+    SvfCoefficients makePeak(double g, double quality, double gainInDecibels) noexcept
+    {
+        const auto A = juce::Decibels::decibelsToGain(gainInDecibels * 0.5, -300.0);
+        const auto k = 1.0 / (quality * A);
+
+        return { (float) g, (float) k, 1.0f, (float) (k * (A * A - 1.0)), 0.0f };
+    }
+}
+
+SvfChainCoefficients makeSvfChainCoefficients(const ChainSettings& chainSettings, double sampleRate) noexcept
+{
+    jassert(sampleRate > 0);
+
+    SvfChainCoefficients result;
+
+    if (isBandActive(chainSettings, ChainPositions::Lowcut))
+        addCut(result, 0, getPrewarpedGain(chainSettings.lowCutFreq, sampleRate), chainSettings.lowCutSlope, true);
+
+    if (isBandActive(chainSettings, ChainPositions::Peak))
+    {
+        result.sections[SvfChainCoefficients::peakSection] = makePeak(getPrewarpedGain(chainSettings.peakFreq, sampleRate),
+                                                                      chainSettings.peakQuality, chainSettings.peakGaininDecibels);
+        result.activeSections |= 1 << SvfChainCoefficients::peakSection;
+    }
+
+    if (isBandActive(chainSettings, ChainPositions::HighCut))
+        addCut(result, SvfChainCoefficients::firstHighCutSection, getPrewarpedGain(chainSettings.highCutFreq, sampleRate),
+               chainSettings.highCutSlope, false);
+
+    return result;
+}
+
+//==============================================================================
+void SvfChain::reset() noexcept
+{
+    ic1eq.fill(0);
+    ic2eq.fill(0);
+}
+
+void SvfChain::setCoefficients(const SvfChainCoefficients& newCoefficients) noexcept
+{
+    // Sections that have just come into use start from a clear state.
+    const auto newlyActive = newCoefficients.activeSections & ~current.activeSections;
+
+    for (int i = 0; i < SvfChainCoefficients::maxSections; ++i)
+    {
+        if ((newlyActive & (1 << i)) != 0)
+        {
+            ic1eq[(size_t) i] = 0;
+            ic2eq[(size_t) i] = 0;
+        }
+    }
+
+    current = target = newCoefficients;
+    rampRemaining = 0;
+    updateSections();
+}
+
+void SvfChain::rampTo(const SvfChainCoefficients& newCoefficients, int numSamples) noexcept
+{
+    if (numSamples <= 0 || newCoefficients.activeSections != current.activeSections)
+    {
+        setCoefficients(newCoefficients);
+        return;
+    }
+
+    target = newCoefficients;
+    rampRemaining = numSamples;
+    const auto scale = 1.0f / (float) numSamples;
+
+    for (int n = 0; n < numActive; ++n)
+    {
+        const auto i = (size_t) activeSlots[(size_t) n];
+        const auto& from = current.sections[i];
+        const auto& to = target.sections[i];
+
+        increments[i] = { (to.g - from.g) * scale, (to.k - from.k) * scale,
+                          (to.m0 - from.m0) * scale, (to.m1 - from.m1) * scale, (to.m2 - from.m2) * scale };
+    }
+}
+
+void SvfChain::updateSections() noexcept
+{
+    numActive = 0;
+
+    for (int i = 0; i < SvfChainCoefficients::maxSections; ++i)
+    {
+        if ((current.activeSections & (1 << i)) == 0)
+            continue;
+
+        const auto& c = current.sections[(size_t) i];
+        const auto a1 = 1.0f / (1.0f + c.g * (c.g + c.k));
+
+        sections[(size_t) i] = { a1, c.g * a1, c.g * c.g * a1, c.m0, c.m1, c.m2 };
+        activeSlots[(size_t) numActive++] = i;
+    }
+}
+
+void SvfChain::process(float* samples, int numSamples) noexcept
+{
+    if (rampRemaining > 0)
+    {
+        const auto numInRamp = juce::jmin(rampRemaining, numSamples);
+        processRamp(samples, numInRamp);
+
+        samples += numInRamp;
+        numSamples -= numInRamp;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = samples[i];
+
+        for (int n = 0; n < numActive; ++n)
+        {
+            const auto k = (size_t) activeSlots[(size_t) n];
+            const auto& s = sections[k];
+            const auto v3 = x - ic2eq[k];
+            const auto v1 = s.a1 * ic1eq[k] + s.a2 * v3;
+            const auto v2 = ic2eq[k] + s.a2 * ic1eq[k] + s.a3 * v3;
+
+            ic1eq[k] = 2.0f * v1 - ic1eq[k];
+            ic2eq[k] = 2.0f * v2 - ic2eq[k];
+            x = s.m0 * x + s.m1 * v1 + s.m2 * v2;
+        }
+
+        samples[i] = x;
+    }
+
+    for (int n = 0; n < numActive; ++n)
+    {
+        juce::dsp::util::snapToZero(ic1eq[(size_t) activeSlots[(size_t) n]]);
+        juce::dsp::util::snapToZero(ic2eq[(size_t) activeSlots[(size_t) n]]);
+    }
+}
+
+void SvfChain::processRamp(float* samples, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = samples[i];
+
+        for (int n = 0; n < numActive; ++n)
+        {
+            const auto k = (size_t) activeSlots[(size_t) n];
+            auto& c = current.sections[k];
+            const auto& step = increments[k];
+
+            c.g += step.g;
+            c.k += step.k;
+            c.m0 += step.m0;
+            c.m1 += step.m1;
+            c.m2 += step.m2;
+
+            const auto a1 = 1.0f / (1.0f + c.g * (c.g + c.k));
+            const auto a2 = c.g * a1;
+            const auto a3 = c.g * a2;
+            const auto v3 = x - ic2eq[k];
+            const auto v1 = a1 * ic1eq[k] + a2 * v3;
+            const auto v2 = ic2eq[k] + a2 * ic1eq[k] + a3 * v3;
+
+            ic1eq[k] = 2.0f * v1 - ic1eq[k];
+            ic2eq[k] = 2.0f * v2 - ic2eq[k];
+            x = c.m0 * x + c.m1 * v1 + c.m2 * v2;
+        }
+
+        samples[i] = x;
+    }
+
+    rampRemaining -= numSamples;
+
+    // Land exactly on the target rather than wherever rounding has got to.
+    if (rampRemaining <= 0)
+    {
+        current = target;
+        updateSections();
+    }
+}
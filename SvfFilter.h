@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    SvfFilter.h
+
+    A topology-preserving (trapezoidal) state variable filter engine, as an
+    alternative to the direct form biquads for the whole chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+/**
+    One section in Andrew Simper's formulation: g = tan(pi f / fs), k = 1/Q,
+    and the output is m0 * input + m1 * band + m2 * low. The defaults pass
+    the input straight through.
+
+    The states are integrator outputs rather than sums of nearly cancelling
+    terms, so a 20 Hz cut at 192 kHz stays accurate in float, where a direct
+    form biquad needs double. Any positive g and k is a stable filter, so the
+    coefficients can be interpolated sample by sample without redesigning.
+*/
+struct SvfCoefficients
+{
+    float g{ 0 }, k{ 2 }, m0{ 1 }, m1{ 0 }, m2{ 0 };
+};
+
+/** The sections of a whole chain, in fixed slots: the low cut stages, the
+    peak, then the high cut stages. Only the slots flagged in activeSections
+    are processed.
+*/
+struct SvfChainCoefficients
+{
+    static constexpr int maxSections = 2 * maxCutStages + 1;
+    static constexpr int peakSection = maxCutStages, firstHighCutSection = maxCutStages + 1;
+
+    std::array<SvfCoefficients, maxSections> sections;
+    int activeSections{ 0 };    // bit (1 << slot) for each slot in use
+};
+
+/** Designs the same responses as makeChainCoefficients(), for the SVF engine,
+    leaving out the bands that aren't isBandActive().
+    Allocation free, and a cut costs one tan() however steep it is.
+*/
+SvfChainCoefficients makeSvfChainCoefficients(const ChainSettings& chainSettings, double sampleRate) noexcept;
+
+//==============================================================================
+/** Runs one channel through an SvfChainCoefficients cascade. */
+class SvfChain
+{
+public:
+    SvfChain() = default;
+
+    void reset() noexcept;
+
+    /** Switches to new coefficients straight away. */
+    void setCoefficients(const SvfChainCoefficients& newCoefficients) noexcept;
+
+    /** Moves linearly to new coefficients over the next numSamples samples.
+        If a different set of sections is active it jumps instead.
+    */
+    void rampTo(const SvfChainCoefficients& newCoefficients, int numSamples) noexcept;
+
+    void process(float* samples, int numSamples) noexcept;
+
+    int getActiveSections() const noexcept { return target.activeSections; }
+
+private:
+    // The per-sample form used by the static path, worked out once.
+    struct Section
+    {
+        float a1, a2, a3, m0, m1, m2;
+    };
+
+    void updateSections() noexcept;
+    void processRamp(float* samples, int numSamples) noexcept;
+
+    SvfChainCoefficients current, target;
+    std::array<SvfCoefficients, SvfChainCoefficients::maxSections> increments;
+    std::array<Section, SvfChainCoefficients::maxSections> sections;
+    std::array<float, SvfChainCoefficients::maxSections> ic1eq{}, ic2eq{};
+    std::array<int, SvfChainCoefficients::maxSections> activeSlots{};
+    int numActive{ 0 }, rampRemaining{ 0 };
+};
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    TimeParallelKernel.cpp
+
+  ==============================================================================
+*/
+
+#include "TimeParallelKernel.h"
+#include "CascadeKernel.h"
+
+namespace
+{
+    template <typename Cut>
+    auto& getStage(Cut& cut, int index) noexcept
+    {
+        switch (index)
+        {
+        case 0: return cut.template get<0>();
+        case 1: return cut.template get<1>();
+        case 2: return cut.template get<2>();
+        default: return cut.template get<3>();
+        }
+    }
+
+    /** Calls visit(section) for each active section of the chain, in order. */
+    template <typename Chain, typename Visitor>
+    void forEachActiveSection(Chain& chain, Visitor&& visit) noexcept
+    {
+        if (! chain.template isBypassed<ChainPositions::Lowcut>())
+            for (int i = 0; i < getNumActiveStages(chain.template get<ChainPositions::Lowcut>()); ++i)
+                visit(getStage(chain.template get<ChainPositions::Lowcut>(), i));
+
+        if (! chain.template isBypassed<ChainPositions::Peak>())
+            visit(chain.template get<ChainPositions::Peak>());
+
+        if (! chain.template isBypassed<ChainPositions::HighCut>())
+            for (int i = 0; i < getNumActiveStages(chain.template get<ChainPositions::HighCut>()); ++i)
+                visit(getStage(chain.template get<ChainPositions::HighCut>(), i));
+    }
+
+    /** The first timeParallelBlockSize outputs of the section for the given
+        input and starting state, worked out in double precision.
+    */
+    std::array<double, timeParallelBlockSize> getResponse(const BiquadCoefficients& c, bool impulse, double s1, double s2) noexcept
+    {
+        std::array<double, timeParallelBlockSize> response;
+
+        for (int k = 0; k < timeParallelBlockSize; ++k)
+        {
+            const auto x = impulse && k == 0 ? 1.0 : 0.0;
+            const auto y = c.b0 * x + s1;
+            s1 = c.b1 * x - c.a1 * y + s2;
+            s2 = c.b2 * x - c.a2 * y;
+            response[(size_t) k] = y;
+        }
+
+        return response;
+    }
+
+    void makeBlockStateSpaceSection(BlockStateSpaceSection& result, const BiquadCoefficients& coefficients) noexcept
+    {
+        const auto impulse = getResponse(coefficients, true, 0, 0);
+        const auto fromState1 = getResponse(coefficients, false, 1, 0);
+        const auto fromState2 = getResponse(coefficients, false, 0, 1);
+
+        for (int k = 0; k < timeParallelBlockSize; ++k)
+        {
+            for (int j = 0; j < timeParallelBlockSize; ++j)
+                result.impulse[j][k] = k >= j ? (float) impulse[(size_t) (k - j)] : 0.0f;
+
+            result.fromState1[k] = (float) fromState1[(size_t) k];
+            result.fromState2[k] = (float) fromState2[(size_t) k];
+        }
+
+        // How the outputs' state-dependent parts carry into the next state.
+        constexpr size_t last = timeParallelBlockSize - 1;
+        const auto a1 = (double) coefficients.a1, a2 = (double) coefficients.a2;
+
+        result.stateToState[0][0] = (float) -(a1 * fromState1[last] + a2 * fromState1[last - 1]);
+        result.stateToState[0][1] = (float) -(a1 * fromState2[last] + a2 * fromState2[last - 1]);
+        result.stateToState[1][0] = (float) (-a2 * fromState1[last]);
+        result.stateToState[1][1] = (float) (-a2 * fromState2[last]);
+        result.coefficients = coefficients;
+    }
+}
+
+void makeTimeParallelCascade(TimeParallelCascade& result, const MonoChain& chain) noexcept
+{
+    result.numSections = 0;
+
+    forEachActiveSection(chain, [&result](const Biquad& section)
+    {
+        makeBlockStateSpaceSection(result.sections[(size_t) result.numSections++], section.coefficients);
+    });
+}
+
+void processTimeParallel(MonoChain& chain, const TimeParallelCascade& cascade, float* samples, int numSamples) noexcept
+{
+   #if JUCE_USE_SIMD
+    using Vector = juce::dsp::SIMDRegister<float>;
+    static_assert(timeParallelBlockSize >= 2, "The state after a block is worked out from its last two samples");
+
+    std::array<Biquad*, maxChainSections> sections;
+    int numSections = 0;
+
+    forEachActiveSection(chain, [&](Biquad& section) { sections[(size_t) numSections++] = &section; });
+
+    // The cascade is out of date if this doesn't hold.
+    jassert(numSections == cascade.numSections);
+    numSections = juce::jmin(numSections, cascade.numSections);
+
+    if (numSections == 0)
+        return;
+
+    float s1[maxChainSections], s2[maxChainSections];
+
+    for (int k = 0; k < numSections; ++k)
+    {
+        s1[k] = sections[(size_t) k]->s1;
+        s2[k] = sections[(size_t) k]->s2;
+    }
+
+    alignas(Vector::SIMDRegisterSize) float frame[timeParallelBlockSize];
+    constexpr int last = timeParallelBlockSize - 1;
+    const auto numInBlocks = numSamples - numSamples % timeParallelBlockSize;
+
+    for (int start = 0; start < numInBlocks; start += timeParallelBlockSize)
+    {
+        std::copy(samples + start, samples + start + timeParallelBlockSize, frame);
+        auto x = Vector::fromRawArray(frame);
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            const auto& section = cascade.sections[(size_t) k];
+            const auto& c = section.coefficients;
+
+            // The part of the output that doesn't depend on the state, which
+            // is the bulk of the work and needn't wait for the last block.
+            auto u = Vector::fromRawArray(section.impulse[0]) * x.get(0) + Vector::fromRawArray(section.impulse[1]) * x.get(1);
+
+            for (int j = 2; j < timeParallelBlockSize; j += 2)
+                u = u + (Vector::fromRawArray(section.impulse[j]) * x.get((size_t) j)
+                         + Vector::fromRawArray(section.impulse[j + 1]) * x.get((size_t) j + 1));
+
+            const auto y = u + (Vector::fromRawArray(section.fromState1) * s1[k] + Vector::fromRawArray(section.fromState2) * s2[k]);
+
+            // The state left after the block comes from the last two inputs
+            // and outputs. Taking the outputs' state-free parts, and the rest
+            // straight from the old state, leaves only two multiply-adds
+            // between one block's state and the next.
+            const auto x1 = x.get(last), x0 = x.get(last - 1);
+            const auto u1 = u.get(last), u0 = u.get(last - 1);
+            const auto input1 = c.b1 * x1 - c.a1 * u1 + c.b2 * x0 - c.a2 * u0;
+            const auto input2 = c.b2 * x1 - c.a2 * u1;
+            const auto old1 = s1[k], old2 = s2[k];
+
+            s1[k] = input1 + section.stateToState[0][0] * old1 + section.stateToState[0][1] * old2;
+            s2[k] = input2 + section.stateToState[1][0] * old1 + section.stateToState[1][1] * old2;
+            x = y;
+        }
+
+        x.copyToRawArray(frame);
+        std::copy(frame, frame + timeParallelBlockSize, samples + start);
+    }
+
+    // Whatever doesn't fill a block runs a sample at a time.
+    for (int i = numInBlocks; i < numSamples; ++i)
+    {
+        auto x = samples[i];
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            const auto& c = cascade.sections[(size_t) k].coefficients;
+            const auto y = c.b0 * x + s1[k];
+            s1[k] = c.b1 * x - c.a1 * y + s2[k];
+            s2[k] = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+
+        samples[i] = x;
+    }
+
+    for (int k = 0; k < numSections; ++k)
+    {
+        sections[(size_t) k]->s1 = s1[k];
+        sections[(size_t) k]->s2 = s2[k];
+        sections[(size_t) k]->snapToZero();
+    }
+   #else
+    juce::ignoreUnused(cascade);
+    processFused(chain, samples, numSamples);
+   #endif
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    TimeParallelKernel.h
+
+    Processing of one channel's MonoChain several samples at a time, using a
+    block state-space form of each section.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterChain.h"
+
+#if JUCE_USE_SIMD
+ /** Samples per step, i.e. one SIMD register of floats. */
+ constexpr int timeParallelBlockSize = (int) juce::dsp::SIMDRegister<float>::SIMDNumElements;
+#else
+ constexpr int timeParallelBlockSize = 2;
+#endif
+
+/**
+    A section turned into a map from a block of input samples and the state
+    at its start to the block of outputs:
+
+        y[k] = sum over j <= k of impulse[j][k] * x[j]
+             + fromState1[k] * s1 + fromState2[k] * s2
+
+    i.e. the lower triangle of the impulse response, and the response to
+    each state variable. Every output of the block is then a handful of
+    vector multiply-adds, rather than each one waiting on the last.
+
+    stateToState takes the state at the start of a block to its part of the
+    state at the end, so the only serial work left from one block to the
+    next is a 2x2 multiply.
+*/
+struct alignas(64) BlockStateSpaceSection
+{
+    alignas(64) float impulse[timeParallelBlockSize][timeParallelBlockSize];
+    alignas(64) float fromState1[timeParallelBlockSize];
+    alignas(64) float fromState2[timeParallelBlockSize];
+    float stateToState[2][2];
+    BiquadCoefficients coefficients;
+};
+
+/** Every active section of one chain in block form, in processing order. */
+struct TimeParallelCascade
+{
+    std::array<BlockStateSpaceSection, maxChainSections> sections;
+    int numSections{ 0 };
+};
+
+/** Works out the block form of the chain's active sections. Call it again
+    whenever the chain's coefficients or bypass flags change; it's cheap, but
+    there's no need to do it every block.
+*/
+void makeTimeParallelCascade(TimeParallelCascade& result, const MonoChain& chain) noexcept;
+
+/** Processes one channel through the chain, timeParallelBlockSize samples
+    at a time, with cascade made from its current coefficients. The state is
+    kept in the chain's sections, so this and processFused() can take turns
+    on the same chain.
+
+    The output matches processFused() to within float rounding. Without
+    SIMD support this just calls processFused().
+*/
+void processTimeParallel(MonoChain& chain, const TimeParallelCascade& cascade, float* samples, int numSamples) noexcept;
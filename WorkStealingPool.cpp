@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.cpp
+
+  ==============================================================================
+*/
+
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int numWorkers)
+{
+    if (numWorkers <= 0)
+        numWorkers = juce::jmax(1, juce::SystemStats::getNumCpus());
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(std::make_unique<Worker>());
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers[(size_t) i]->thread = std::thread([this, i] { workerLoop(i); });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        const std::lock_guard<std::mutex> sl(runLock);
+        shouldExit = true;
+    }
+
+    workAvailable.notify_all();
+
+    for (auto& worker : workers)
+        worker->thread.join();
+}
+
+void WorkStealingPool::run(int numTasks, const Task& task)
+{
+    if (numTasks <= 0)
+        return;
+
+    std::unique_lock<std::mutex> sl(runLock);
+    currentTask = &task;
+    remainingTasks = numTasks;
+
+    // Deal out contiguous ranges so neighbouring tasks tend to stay on the
+    // same worker until someone needs to steal. This happens under runLock so
+    // a task can never be picked up before currentTask points at its batch.
+    const auto numWorkers = getNumWorkers();
+
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        auto& worker = *workers[(size_t) w];
+        const std::lock_guard<std::mutex> queueLock(worker.lock);
+
+        for (int t = (int) ((juce::int64) numTasks * w / numWorkers); t < (int) ((juce::int64) numTasks * (w + 1) / numWorkers); ++t)
+            worker.tasks.push_front(t);
+    }
+
+    ++generation;
+    workAvailable.notify_all();
+
+    workFinished.wait(sl, [this] { return remainingTasks == 0; });
+    currentTask = nullptr;
+}
+
+bool WorkStealingPool::takeTask(int workerIndex, int& taskIndex)
+{
+    {
+        auto& own = *workers[(size_t) workerIndex];
+        const std::lock_guard<std::mutex> sl(own.lock);
+
+        if (! own.tasks.empty())
+        {
+            taskIndex = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    const auto numWorkers = getNumWorkers();
+
+    for (int i = 1; i < numWorkers; ++i)
+    {
+        auto& victim = *workers[(size_t) ((workerIndex + i) % numWorkers)];
+        const std::lock_guard<std::mutex> sl(victim.lock);
+
+        if (! victim.tasks.empty())
+        {
+            taskIndex = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int workerIndex)
+{
+    int seenGeneration = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> sl(runLock);
+            workAvailable.wait(sl, [&] { return shouldExit || generation != seenGeneration; });
+
+            if (shouldExit)
+                return;
+
+            seenGeneration = generation;
+        }
+
+        int taskIndex = 0;
+
+        while (takeTask(workerIndex, taskIndex))
+        {
+            // The batch can't finish while this task is outstanding, so the
+            // pointer stays valid until remainingTasks is decremented below.
+            const Task* task = nullptr;
+
+            {
+                const std::lock_guard<std::mutex> sl(runLock);
+                task = currentTask;
+            }
+
+            (*task)(taskIndex, workerIndex);
+
+            const std::lock_guard<std::mutex> sl(runLock);
+
+            if (--remainingTasks == 0)
+                workFinished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+
+    A fixed set of worker threads that share out batches of indexed tasks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+    Each call to run() deals the tasks out to the workers' own queues. A worker
+    takes tasks from the back of its queue and, once that is empty, steals from
+    the front of the others', so uneven task lengths still keep every worker
+    busy. The worker index passed to each task lets callers keep per-worker
+    state (such as one filter chain per worker) without any locking.
+*/
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(int taskIndex, int workerIndex)>;
+
+    /** Creates the workers. Zero or less means one per hardware thread. */
+    explicit WorkStealingPool(int numWorkers = 0);
+    ~WorkStealingPool();
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+
+    /** Runs task for every index in [0, numTasks) and waits for them all. */
+    void run(int numTasks, const Task& task);
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<int> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex runLock;
+    std::condition_variable workAvailable, workFinished;
+    const Task* currentTask{ nullptr };
+    int generation{ 0 }, remainingTasks{ 0 };
+    bool shouldExit{ false };
+
+    void workerLoop(int workerIndex);
+    bool takeTask(int workerIndex, int& taskIndex);
+
+    JUCE_DECLARE_NON_COPYABLE(WorkStealingPool)
+};